@@ -0,0 +1,161 @@
+// Part of the Ziv Programming Language, under the Apache License v2.0 with LLVM
+// See /LICENSE for license details.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef ZIV_BENCHMARKS_CORPUS_HPP
+#define ZIV_BENCHMARKS_CORPUS_HPP
+
+#include <optional>
+#include <random>
+#include <string>
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "toolchain/source/source_buffer.hpp"
+
+namespace ziv::benchmarks {
+
+// Shapes of synthetic source used to exercise different lexer paths.
+enum class CorpusShape {
+    Identifiers,  // Declarations and assignments between long identifiers
+    Operators,    // Dense arithmetic, comparison and compound assignment expressions
+    Indentation,  // Deeply nested blocks producing Indent/Dedent runs
+    Comments,     // Single and multi-line comments around little code
+    Literals,     // Integer, float, hex, binary, string and char literals
+};
+
+inline constexpr size_t CORPUS_NESTING_DEPTH = 16;
+
+// Generates roughly `target_bytes` of lexically valid source of the given
+// shape. The output is deterministic so runs can be compared.
+inline std::string generate_corpus(CorpusShape shape, size_t target_bytes) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> small(0, 999);
+    auto name = [&](const char* prefix) {
+        return std::string(prefix) + "_" + std::to_string(small(rng));
+    };
+
+    std::string out;
+    out.reserve(target_bytes + 256);
+
+    while (out.size() < target_bytes) {
+        switch (shape) {
+        case CorpusShape::Identifiers:
+            out += "let " + name("value") + ": int = " + name("other") + "\n";
+            out += "var " + name("counter") + " = " + name("value") + "\n";
+            out += name("result") + " = " + name("lhs") + "\n";
+            break;
+        case CorpusShape::Operators:
+            out += "x = a + b * c - d / e % f\n";
+            out += "y += (a << 2) | (b & c) ^ ~d\n";
+            out += "z = a == b != c <= d >= e < f > g\n";
+            out += "i++\n";
+            out += "w -= i-- * -j\n";
+            break;
+        case CorpusShape::Indentation: {
+            out += "fn " + name("nested") + "():\n";
+            std::string indent = "    ";
+            for (size_t depth = 0; depth < CORPUS_NESTING_DEPTH; ++depth) {
+                out += indent + "if " + name("cond") + ":\n";
+                indent += "    ";
+            }
+            out += indent + "ret " + name("value") + "\n";
+            break;
+        }
+        case CorpusShape::Comments:
+            out += "# single-line comment describing " + name("thing") + "\n";
+            out += "#-- multi-line comment\n    spanning several lines\n    with "
+                   + name("words") + " --#\n";
+            out += "let " + name("value") + " = 1  # trailing comment\n";
+            break;
+        case CorpusShape::Literals:
+            out += "let a = " + std::to_string(small(rng)) + "\n";
+            out += "let b = " + std::to_string(small(rng)) + ".25e-3\n";
+            out += "let c = 0x1F2E3D\n";
+            out += "let d = 0b101101\n";
+            out += "let e = \"string with \\\"escapes\\\"\\n and \\t tabs\"\n";
+            out += "let f = 'c'\n";
+            break;
+        }
+    }
+    return out;
+}
+
+// Grammar constructs exercised by the parser benchmarks.
+enum class ConstructShape {
+    BinaryChains,       // Returns of long left-associative operator chains
+    NestedIfs,          // Functions nesting if statements CORPUS_NESTING_DEPTH deep
+    GenericParameters,  // Functions with long constrained generic parameter lists
+    CallArguments,      // Calls with long argument lists
+    SmallFunctions,     // Many one-statement functions
+    Imports,            // Plain and selective module imports
+};
+
+inline constexpr size_t CONSTRUCT_LIST_LENGTH = 64;
+
+// Generates roughly `target_bytes` of source that parses without
+// diagnostics, built from repetitions of one construct.
+inline std::string generate_constructs(ConstructShape shape, size_t target_bytes) {
+    std::string out;
+    out.reserve(target_bytes + 1024);
+
+    for (size_t n = 0; out.size() < target_bytes; ++n) {
+        const std::string id = std::to_string(n);
+        switch (shape) {
+        case ConstructShape::BinaryChains: {
+            static constexpr const char* OPERATORS[] = {" + ", " * ", " - ", " / "};
+            out += "fn chain_" + id + "(a: int) -> int:\n    ret a";
+            for (size_t i = 1; i < CONSTRUCT_LIST_LENGTH; ++i) {
+                out += OPERATORS[i % 4];
+                out += "v" + std::to_string(i);
+            }
+            out += "\n";
+            break;
+        }
+        case ConstructShape::NestedIfs: {
+            out += "fn nested_" + id + "(a: int):\n";
+            std::string indent = "    ";
+            for (size_t depth = 0; depth < CORPUS_NESTING_DEPTH; ++depth) {
+                out += indent + "if a:\n";
+                indent += "    ";
+            }
+            out += indent + "ret a\n";
+            break;
+        }
+        case ConstructShape::GenericParameters:
+            out += "fn generic_" + id + "[";
+            for (size_t i = 0; i < CONSTRUCT_LIST_LENGTH; ++i) {
+                out += (i ? ", T" : "T") + std::to_string(i) + ": Trait";
+            }
+            out += "](a: int) -> int:\n    ret a\n";
+            break;
+        case ConstructShape::CallArguments:
+            out += "fn call_" + id + "(a: int):\n    ret callee(a";
+            for (size_t i = 1; i < CONSTRUCT_LIST_LENGTH; ++i) {
+                out += ", v" + std::to_string(i);
+            }
+            out += ")\n";
+            break;
+        case ConstructShape::SmallFunctions:
+            out += "fn small_" + id + "(a: int) -> int:\n    ret a\n";
+            break;
+        case ConstructShape::Imports:
+            out += "import module_" + id + "\n";
+            out += "import module_" + id + " {first, second, third}\n";
+            break;
+        }
+    }
+    return out;
+}
+
+// Loads generated text as a SourceBuffer. The buffer references memory owned
+// by `fs`, which must outlive it.
+inline std::optional<toolchain::source::SourceBuffer> load_corpus(llvm::vfs::InMemoryFileSystem& fs,
+                                                                  const std::string& text) {
+    fs.addFile("/bench/corpus.ziv", 0, llvm::MemoryBuffer::getMemBufferCopy(text));
+    return toolchain::source::SourceBuffer::from_file(fs, "/bench/corpus.ziv");
+}
+
+}  // namespace ziv::benchmarks
+
+#endif  // ZIV_BENCHMARKS_CORPUS_HPP
@@ -0,0 +1,57 @@
+// Part of the Ziv Programming Language, under the Apache License v2.0 with LLVM
+// See /LICENSE for license details.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "benchmarks/corpus.hpp"
+#include "toolchain/diagnostics/diagnostic_consumer.hpp"
+#include "toolchain/lex/lexer.hpp"
+
+namespace ziv::benchmarks {
+
+static void lex_corpus(benchmark::State& state, CorpusShape shape) {
+    std::string text = generate_corpus(shape, static_cast<size_t>(state.range(0)));
+    llvm::vfs::InMemoryFileSystem fs;
+    auto source = load_corpus(fs, text);
+    if (!source) {
+        state.SkipWithError("failed to load generated corpus");
+        return;
+    }
+
+    auto consumer = std::make_shared<toolchain::diagnostics::ConsoleDiagnosticConsumer>(*source);
+    size_t token_count = 0;
+
+    for (auto _ : state) {
+        toolchain::lex::Lexer lexer(*source, consumer);
+        lexer.lex();
+        token_count = lexer.get_tokens().size();
+        benchmark::DoNotOptimize(lexer.get_tokens().data());
+    }
+
+    if (consumer->has_errors()) {
+        state.SkipWithError("generated corpus produced lexer diagnostics");
+        return;
+    }
+
+    auto iterations = static_cast<int64_t>(state.iterations());
+    state.SetBytesProcessed(iterations * static_cast<int64_t>(text.size()));
+    state.counters["tokens"] = benchmark::Counter(static_cast<double>(token_count));
+    state.counters["tokens/s"] = benchmark::Counter(
+        static_cast<double>(token_count) * static_cast<double>(iterations),
+        benchmark::Counter::kIsRate);
+}
+
+// Input size in bytes: 4 KiB up to 4 MiB.
+#define ZIV_LEXER_BENCHMARK(NAME, SHAPE)                                                           \
+    BENCHMARK_CAPTURE(lex_corpus, NAME, SHAPE)->RangeMultiplier(8)->Range(4 << 10, 4 << 20)
+
+ZIV_LEXER_BENCHMARK(identifiers, CorpusShape::Identifiers);
+ZIV_LEXER_BENCHMARK(operators, CorpusShape::Operators);
+ZIV_LEXER_BENCHMARK(indentation, CorpusShape::Indentation);
+ZIV_LEXER_BENCHMARK(comments, CorpusShape::Comments);
+ZIV_LEXER_BENCHMARK(literals, CorpusShape::Literals);
+
+}  // namespace ziv::benchmarks
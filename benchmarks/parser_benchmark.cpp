@@ -0,0 +1,158 @@
+// Part of the Ziv Programming Language, under the Apache License v2.0 with LLVM
+// See /LICENSE for license details.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+
+#include "benchmarks/corpus.hpp"
+#include "toolchain/ast/serialization.hpp"
+#include "toolchain/ast/tree.hpp"
+#include "toolchain/diagnostics/diagnostic_consumer.hpp"
+#include "toolchain/lex/lexer.hpp"
+#include "toolchain/parser/parser.hpp"
+
+// The parser allocates through both operator new and LLVM's safe_malloc, so the
+// counter hooks the C allocator that both end up in. Only glibc exposes the
+// underlying entry points; elsewhere bytes/node reports zero. A realloc()
+// counts only what it adds to the block, so growing a vector in place is not
+// charged for the elements it already held.
+static std::atomic<size_t> allocated_bytes{0};
+
+#ifdef __GLIBC__
+    #include <malloc.h>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* memory, size_t size);
+
+void* malloc(size_t size) {
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    allocated_bytes.fetch_add(count * size, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* memory, size_t size) {
+    const size_t old_size = memory != nullptr ? malloc_usable_size(memory) : 0;
+    if (size > old_size) {
+        allocated_bytes.fetch_add(size - old_size, std::memory_order_relaxed);
+    }
+    return __libc_realloc(memory, size);
+}
+}
+#endif
+
+namespace ziv::benchmarks {
+
+static void parse_constructs(benchmark::State& state, ConstructShape shape) {
+    std::string text = generate_constructs(shape, static_cast<size_t>(state.range(0)));
+    llvm::vfs::InMemoryFileSystem fs;
+    auto source = load_corpus(fs, text);
+    if (!source) {
+        state.SkipWithError("failed to load generated corpus");
+        return;
+    }
+
+    // Tokens are produced once; only parsing is measured
+    auto consumer = std::make_shared<toolchain::diagnostics::ConsoleDiagnosticConsumer>(*source);
+    toolchain::lex::Lexer lexer(*source, consumer);
+    lexer.lex();
+
+    size_t node_count = 0;
+    size_t parse_bytes = 0;
+    for (auto _ : state) {
+        const size_t bytes_before = allocated_bytes.load(std::memory_order_relaxed);
+        toolchain::ast::AST ast;
+        toolchain::parser::Parser parser(lexer.get_buffer(), ast, consumer, *source);
+        parser.parse();
+        parse_bytes += allocated_bytes.load(std::memory_order_relaxed) - bytes_before;
+        node_count = ast.size();
+        benchmark::DoNotOptimize(ast.get_root());
+    }
+
+    if (consumer->has_errors()) {
+        state.SkipWithError("generated corpus produced diagnostics");
+        return;
+    }
+
+    auto iterations = static_cast<double>(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations())
+                            * static_cast<int64_t>(text.size()));
+    state.counters["nodes"] = benchmark::Counter(static_cast<double>(node_count));
+    state.counters["nodes/s"] = benchmark::Counter(static_cast<double>(node_count) * iterations,
+                                                   benchmark::Counter::kIsRate);
+    state.counters["bytes/node"] = benchmark::Counter(
+        static_cast<double>(parse_bytes) / (static_cast<double>(node_count) * iterations));
+}
+
+// Reloads a parse cached with SerializedAST and visits every node, the work a
+// build reusing the cache does instead of parse_constructs.
+static void load_serialized(benchmark::State& state, ConstructShape shape) {
+    std::string text = generate_constructs(shape, static_cast<size_t>(state.range(0)));
+    llvm::vfs::InMemoryFileSystem fs;
+    auto source = load_corpus(fs, text);
+    if (!source) {
+        state.SkipWithError("failed to load generated corpus");
+        return;
+    }
+
+    auto consumer = std::make_shared<toolchain::diagnostics::ConsoleDiagnosticConsumer>(*source);
+    toolchain::lex::Lexer lexer(*source, consumer);
+    lexer.lex();
+    toolchain::ast::AST ast;
+    toolchain::parser::Parser parser(lexer.get_buffer(), ast, consumer, *source);
+    parser.parse();
+
+    std::string bytes;
+    llvm::raw_string_ostream out(bytes);
+    toolchain::ast::SerializedAST::write(ast, out);
+    out.flush();
+
+    for (auto _ : state) {
+        auto loaded = toolchain::ast::SerializedAST::from_buffer(
+            llvm::MemoryBuffer::getMemBuffer(bytes, "cache.zast", false));
+        if (!loaded) {
+            state.SkipWithError("failed to load serialized tree");
+            return;
+        }
+        size_t errors = 0;
+        for (size_t index = 1; index < loaded->size(); ++index) {
+            errors += loaded->has_error(toolchain::ast::NodeId(static_cast<uint32_t>(index)));
+        }
+        benchmark::DoNotOptimize(errors);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations())
+                            * static_cast<int64_t>(text.size()));
+    auto node_count = static_cast<double>(ast.size());
+    state.counters["nodes/s"] =
+        benchmark::Counter(node_count * static_cast<double>(state.iterations()),
+                           benchmark::Counter::kIsRate);
+    state.counters["file bytes/node"] =
+        benchmark::Counter(static_cast<double>(bytes.size()) / node_count);
+}
+
+// Input size in bytes: 4 KiB up to 4 MiB.
+#define ZIV_PARSER_BENCHMARK(NAME, SHAPE)                                                          \
+    BENCHMARK_CAPTURE(parse_constructs, NAME, SHAPE)->RangeMultiplier(8)->Range(4 << 10, 4 << 20)
+
+ZIV_PARSER_BENCHMARK(binary_chains, ConstructShape::BinaryChains);
+ZIV_PARSER_BENCHMARK(nested_ifs, ConstructShape::NestedIfs);
+ZIV_PARSER_BENCHMARK(generic_parameters, ConstructShape::GenericParameters);
+ZIV_PARSER_BENCHMARK(call_arguments, ConstructShape::CallArguments);
+ZIV_PARSER_BENCHMARK(small_functions, ConstructShape::SmallFunctions);
+ZIV_PARSER_BENCHMARK(imports, ConstructShape::Imports);
+
+BENCHMARK_CAPTURE(load_serialized, small_functions, ConstructShape::SmallFunctions)
+    ->RangeMultiplier(8)
+    ->Range(4 << 10, 4 << 20);
+
+}  // namespace ziv::benchmarks
@@ -0,0 +1,85 @@
+// Part of the Ziv Programming Language, under the Apache License v2.0 with LLVM
+// See /LICENSE for license details.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <optional>
+
+#include "llvm/Support/VirtualFileSystem.h"
+#include "toolchain/ast/tree.hpp"
+#include "toolchain/diagnostics/diagnostic_consumer.hpp"
+#include "toolchain/lex/lexer.hpp"
+#include "toolchain/parser/parser.hpp"
+#include "toolchain/semantics/checker.hpp"
+#include "toolchain/source/source_buffer.hpp"
+
+namespace ziv::toolchain::semantics {
+
+class CheckerTest : public ::testing::Test {
+protected:
+    llvm::vfs::InMemoryFileSystem fs;
+    std::optional<source::SourceBuffer> source;
+    std::shared_ptr<diagnostics::ConsoleDiagnosticConsumer> consumer;
+    std::unique_ptr<lex::Lexer> lexer;
+    ast::AST ast;
+
+    void SetUp() override {
+        diagnostics::DiagnosticContext::instance().reset();
+    }
+
+    // Parses `text` and runs the checker over it
+    bool check(llvm::StringRef text) {
+        fs.addFile("/test/input.ziv", 0, llvm::MemoryBuffer::getMemBufferCopy(text));
+        source = source::SourceBuffer::from_file(fs, "/test/input.ziv");
+        EXPECT_TRUE(source.has_value());
+
+        consumer = std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*source);
+        lexer = std::make_unique<lex::Lexer>(*source, consumer);
+        lexer->lex();
+        parser::Parser(lexer->get_buffer(), ast, consumer, *source).parse();
+        EXPECT_TRUE(consumer->diagnostics().empty());
+
+        return SemanticChecker(ast, consumer, *source).check();
+    }
+
+    bool has_diagnostic(diagnostics::DiagnosticKind kind) const {
+        for (const auto& diagnostic : consumer->diagnostics()) {
+            if (diagnostic.kind == kind) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+TEST_F(CheckerTest, SiblingBlocksMayReuseNames) {
+    EXPECT_TRUE(check("fn f(a: int) -> int:\n"
+                      "    while a:\n"
+                      "        let m x: int = 1;\n"
+                      "    while a:\n"
+                      "        let m x: int = 2;\n"));
+    EXPECT_FALSE(has_diagnostic(diagnostics::DiagnosticKind::VariableRedeclaration()));
+}
+
+// Semantic errors end the compilation, so these run in a child process
+TEST_F(CheckerTest, RedeclarationInSameBlock) {
+    EXPECT_EXIT(check("fn f(a: int) -> int:\n"
+                      "    while a:\n"
+                      "        let m x: int = 1;\n"
+                      "        let m x: int = 2;\n"),
+                ::testing::ExitedWithCode(1),
+                "ZIV-3002");
+}
+
+TEST_F(CheckerTest, NestedBlockCannotShadow) {
+    EXPECT_EXIT(check("fn f(a: int) -> int:\n"
+                      "    let m x: int = 1;\n"
+                      "    while a:\n"
+                      "        let m x: int = 2;\n"),
+                ::testing::ExitedWithCode(1),
+                "ZIV-3002");
+}
+
+}  // namespace ziv::toolchain::semantics
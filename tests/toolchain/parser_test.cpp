@@ -0,0 +1,869 @@
+// Part of the Ziv Programming Language, under the Apache License v2.0 with LLVM
+// See /LICENSE for license details.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "toolchain/ast/printer.hpp"
+#include "toolchain/ast/serialization.hpp"
+#include "toolchain/ast/tree.hpp"
+#include "toolchain/ast/visitor.hpp"
+#include "toolchain/diagnostics/diagnostic_consumer.hpp"
+#include "toolchain/lex/lexer.hpp"
+#include "toolchain/parser/parser.hpp"
+#include "toolchain/source/source_buffer.hpp"
+
+namespace ziv::toolchain::parser {
+
+class ParserTest : public ::testing::Test {
+protected:
+    llvm::vfs::InMemoryFileSystem fs;
+    std::optional<source::SourceBuffer> source;
+    std::shared_ptr<diagnostics::ConsoleDiagnosticConsumer> consumer;
+    std::unique_ptr<lex::Lexer> lexer;
+    ast::AST ast;
+    ParserOptions options;
+
+    void SetUp() override {
+        diagnostics::DiagnosticContext::instance().reset();
+    }
+
+    void parse(llvm::StringRef text) {
+        fs.addFile("/test/input.ziv", 0, llvm::MemoryBuffer::getMemBufferCopy(text));
+        source = source::SourceBuffer::from_file(fs, "/test/input.ziv");
+        ASSERT_TRUE(source.has_value());
+
+        consumer = std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*source);
+        lexer = std::make_unique<lex::Lexer>(*source, consumer);
+        lexer->lex();
+
+        Parser parser(lexer->get_buffer(), ast, consumer, *source, options);
+        parser.parse();
+    }
+
+    // Parses `fn f():` returning `expression` and yields the returned node.
+    ast::AST::Node parse_return(llvm::StringRef expression) {
+        parse(("fn f():\n    ret " + expression + "\n").str());
+        auto ret = find_first(ast.get_root(), ast::NodeKind::ReturnStmt());
+        if (!ret.is_valid()) {
+            return ret;
+        }
+        auto operands = children(ret);
+        return operands.empty() ? ast::AST::Node() : operands.front();
+    }
+
+    std::vector<ast::AST::Node> children(ast::AST::Node node) const {
+        std::vector<ast::AST::Node> result;
+        for (auto child : ast.children(node)) {
+            result.push_back(child);
+        }
+        return result;
+    }
+
+    ast::AST::Node find_first(ast::AST::Node node, ast::NodeKind kind) const {
+        if (ast.get_kind(node) == kind) {
+            return node;
+        }
+        for (auto child : ast.children(node)) {
+            auto found = find_first(child, kind);
+            if (found.is_valid()) {
+                return found;
+            }
+        }
+        return ast::AST::Node();
+    }
+
+    size_t count(ast::AST::Node node, ast::NodeKind kind) const {
+        size_t total = ast.get_kind(node) == kind ? 1 : 0;
+        for (auto child : ast.children(node)) {
+            total += count(child, kind);
+        }
+        return total;
+    }
+
+    // Compares trees that may be stored differently, like an AST and a
+    // SerializedAST
+    template <typename LhsTree, typename RhsTree>
+    static bool same_tree(const LhsTree& lhs_ast,
+                          ast::NodeId lhs,
+                          const RhsTree& rhs_ast,
+                          ast::NodeId rhs) {
+        if (lhs_ast.get_kind(lhs) != rhs_ast.get_kind(rhs)
+            || lhs_ast.get_spelling(lhs) != rhs_ast.get_spelling(rhs)
+            || lhs_ast.get_location(lhs).line != rhs_ast.get_location(rhs).line
+            || lhs_ast.get_location(lhs).column != rhs_ast.get_location(rhs).column
+            || lhs_ast.has_error(lhs) != rhs_ast.has_error(rhs)) {
+            return false;
+        }
+
+        auto lhs_children = lhs_ast.children(lhs);
+        auto rhs_children = rhs_ast.children(rhs);
+        auto lhs_it = lhs_children.begin();
+        auto rhs_it = rhs_children.begin();
+        for (; lhs_it != lhs_children.end() && rhs_it != rhs_children.end(); ++lhs_it, ++rhs_it) {
+            if (!same_tree(lhs_ast, *lhs_it, rhs_ast, *rhs_it)) {
+                return false;
+            }
+        }
+        return lhs_it == lhs_children.end() && rhs_it == rhs_children.end();
+    }
+
+    bool has_diagnostic(diagnostics::DiagnosticKind kind) const {
+        for (const auto& diagnostic : consumer->diagnostics()) {
+            if (diagnostic.kind == kind) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+TEST_F(ParserTest, BinaryPrecedence) {
+    // a + b * c - d  =>  (a + (b * c)) - d
+    auto expr = parse_return("a + b * c - d");
+    ASSERT_TRUE(expr.is_valid());
+    EXPECT_EQ(ast.get_kind(expr), ast::NodeKind::BinaryExpr());
+    EXPECT_EQ(ast.get_spelling(expr), "-");
+
+    auto outer = children(expr);
+    ASSERT_EQ(outer.size(), 2u);
+    EXPECT_EQ(ast.get_spelling(outer[0]), "+");
+    EXPECT_EQ(ast.get_spelling(outer[1]), "d");
+
+    auto sum = children(outer[0]);
+    ASSERT_EQ(sum.size(), 2u);
+    EXPECT_EQ(ast.get_spelling(sum[0]), "a");
+    EXPECT_EQ(ast.get_spelling(sum[1]), "*");
+    EXPECT_TRUE(consumer->diagnostics().empty());
+}
+
+TEST_F(ParserTest, BinaryLeftAssociative) {
+    // a - b - c  =>  (a - b) - c
+    auto expr = parse_return("a - b - c");
+    ASSERT_TRUE(expr.is_valid());
+
+    auto operands = children(expr);
+    ASSERT_EQ(operands.size(), 2u);
+    EXPECT_EQ(ast.get_spelling(operands[0]), "-");
+    EXPECT_EQ(ast.get_spelling(operands[1]), "c");
+    EXPECT_TRUE(consumer->diagnostics().empty());
+}
+
+TEST_F(ParserTest, BitwiseBelowArithmetic) {
+    // a | b * c  =>  a | (b * c)
+    auto expr = parse_return("a | b * c");
+    ASSERT_TRUE(expr.is_valid());
+    EXPECT_EQ(ast.get_spelling(expr), "|");
+
+    auto operands = children(expr);
+    ASSERT_EQ(operands.size(), 2u);
+    EXPECT_EQ(ast.get_spelling(operands[1]), "*");
+    EXPECT_TRUE(consumer->diagnostics().empty());
+}
+
+TEST_F(ParserTest, AmbiguousOperators) {
+    auto expr = parse_return("a & b | c");
+    ASSERT_TRUE(expr.is_valid());
+    EXPECT_TRUE(has_diagnostic(diagnostics::DiagnosticKind::AmbiguousOperators()));
+
+    auto error = find_first(expr, ast::NodeKind::Error());
+    ASSERT_TRUE(error.is_valid());
+    EXPECT_TRUE(ast.has_error(error));
+    EXPECT_EQ(ast.get_spelling(error), "|");
+}
+
+TEST_F(ParserTest, AmbiguityIsCheckedAgainstEnclosingOperator) {
+    // `&` follows `c` inside the right operand of `|`, not the `*` before it.
+    parse_return("a * b | c & d");
+    EXPECT_TRUE(has_diagnostic(diagnostics::DiagnosticKind::AmbiguousOperators()));
+}
+
+TEST_F(ParserTest, SeparateExpressionsAreNotCompared) {
+    parse("fn f():\n    ret a + b\nfn g():\n    ret c | d\n");
+    EXPECT_FALSE(has_diagnostic(diagnostics::DiagnosticKind::AmbiguousOperators()));
+}
+
+TEST_F(ParserTest, DeeplyNestedParentheses) {
+    constexpr size_t DEPTH = 100000;
+    auto expr = parse_return(std::string(DEPTH, '(') + "a" + std::string(DEPTH, ')'));
+    ASSERT_TRUE(expr.is_valid());
+    EXPECT_EQ(ast.get_kind(expr), ast::NodeKind::IdentifierExpr());
+    EXPECT_TRUE(consumer->diagnostics().empty());
+}
+
+TEST_F(ParserTest, DeeplyNestedUnaryOperators) {
+    constexpr size_t DEPTH = 100000;
+    std::string text;
+    for (size_t i = 0; i < DEPTH; ++i) {
+        text += "- ";
+    }
+    auto expr = parse_return(text + "a");
+
+    size_t depth = 0;
+    while (expr.is_valid() && ast.get_kind(expr) == ast::NodeKind::UnaryExpr()) {
+        auto operands = children(expr);
+        ASSERT_EQ(operands.size(), 1u);
+        expr = operands.front();
+        ++depth;
+    }
+    EXPECT_EQ(depth, DEPTH);
+    EXPECT_EQ(ast.get_spelling(expr), "a");
+    EXPECT_TRUE(consumer->diagnostics().empty());
+}
+
+TEST_F(ParserTest, DeeplyNestedBlocks) {
+    constexpr size_t DEPTH = 1000;
+    std::string text = "fn f():\n";
+    for (size_t i = 1; i <= DEPTH; ++i) {
+        text += std::string(i * 4, ' ') + "if a:\n";
+    }
+    text += std::string((DEPTH + 1) * 4, ' ') + "ret b\n";
+    parse(text);
+
+    EXPECT_EQ(count(ast.get_root(), ast::NodeKind::IfStatement()), DEPTH);
+    EXPECT_EQ(count(ast.get_root(), ast::NodeKind::ReturnStmt()), 1u);
+    EXPECT_TRUE(consumer->diagnostics().empty());
+}
+
+TEST_F(ParserTest, ExpressionNestingLimit) {
+    options.max_nesting_depth = 8;
+    parse("fn f():\n    ret " + std::string(20, '(') + "a" + std::string(20, ')')
+          + " + b\nfn g():\n    ret c\n");
+
+    EXPECT_TRUE(has_diagnostic(diagnostics::DiagnosticKind::NestingTooDeep()));
+    EXPECT_FALSE(has_diagnostic(diagnostics::DiagnosticKind::UnexpectedToken()));
+    EXPECT_EQ(count(ast.get_root(), ast::NodeKind::BinaryExpr()), 1u);
+    EXPECT_EQ(count(ast.get_root(), ast::NodeKind::FunctionDecl()), 2u);
+}
+
+TEST_F(ParserTest, BlockNestingLimit) {
+    options.max_nesting_depth = 3;
+    std::string text = "fn f():\n";
+    for (size_t i = 1; i <= 6; ++i) {
+        text += std::string(i * 4, ' ') + "if a:\n";
+    }
+    text += std::string(7 * 4, ' ') + "ret b\nfn g():\n    ret c\n";
+    parse(text);
+
+    EXPECT_TRUE(has_diagnostic(diagnostics::DiagnosticKind::NestingTooDeep()));
+    EXPECT_FALSE(has_diagnostic(diagnostics::DiagnosticKind::UnexpectedToken()));
+    EXPECT_EQ(count(ast.get_root(), ast::NodeKind::IfStatement()), 3u);
+    EXPECT_EQ(count(ast.get_root(), ast::NodeKind::FunctionDecl()), 2u);
+}
+
+TEST_F(ParserTest, ModulesAndImportsAreDeclarations) {
+    parse("import std\nmodule geometry\nfn area(r: int) -> int:\n    ret r * r\nend module\n"
+          "fn main():\n    ret 0\n");
+
+    std::vector<ast::NodeKind> kinds;
+    for (auto node : ast.children(ast.get_root())) {
+        kinds.push_back(ast.get_kind(node));
+    }
+    EXPECT_EQ(kinds,
+              (std::vector<ast::NodeKind>{ast::NodeKind::ModuleImport(),
+                                          ast::NodeKind::ModuleDecl(),
+                                          ast::NodeKind::FunctionDecl(),
+                                          ast::NodeKind::FileEnd()}));
+    EXPECT_TRUE(consumer->diagnostics().empty());
+}
+
+TEST_F(ParserTest, ImportAliasesAndItems) {
+    parse("import io as stream\nimport math { sin, cos }\nfn main():\n    ret 0\n");
+
+    auto alias = find_first(ast.get_root(), ast::NodeKind::ModuleAlias());
+    ASSERT_TRUE(alias.is_valid());
+    EXPECT_EQ(ast.get_spelling(alias), "stream");
+
+    auto items = children(find_first(ast.get_root(), ast::NodeKind::ModuleImportList()));
+    ASSERT_EQ(items.size(), 2u);
+    EXPECT_EQ(ast.get_spelling(items[0]), "sin");
+    EXPECT_EQ(ast.get_spelling(items[1]), "cos");
+
+    // The declaration after the imports is not swallowed by them
+    EXPECT_EQ(count(ast.get_root(), ast::NodeKind::FunctionDecl()), 1u);
+    EXPECT_TRUE(consumer->diagnostics().empty());
+}
+
+TEST_F(ParserTest, ModuleBodiesParseFunctionBodies) {
+    parse("module geometry\nfn area(r: int) -> int:\n    ret r * r\n"
+          "fn twice(r: int) -> int:\n    ret r + r\nend module\n");
+
+    auto module = find_first(ast.get_root(), ast::NodeKind::ModuleDecl());
+    ASSERT_TRUE(module.is_valid());
+    EXPECT_EQ(count(module, ast::NodeKind::FunctionDecl()), 2u);
+    EXPECT_EQ(count(module, ast::NodeKind::CodeBlock()), 2u);
+    EXPECT_EQ(count(module, ast::NodeKind::ReturnStmt()), 2u);
+    EXPECT_EQ(count(module, ast::NodeKind::BinaryExpr()), 2u);
+    EXPECT_TRUE(consumer->diagnostics().empty());
+}
+
+TEST_F(ParserTest, ParallelParseMatchesSequential) {
+    std::string text;
+    for (size_t i = 0; i < 64; ++i) {
+        auto name = std::to_string(i);
+        text += "fn f" + name + "(a: int) -> int:\n    if a:\n        ret a * " + name + "\n";
+        // Every eighth declaration carries a parse error
+        text += i % 8 == 0 ? "    ret (a + \n" : "    ret a & b\n";
+    }
+    parse(text);
+
+    ast::AST parallel_ast;
+    auto parallel_consumer = std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*source);
+    Parser parallel(lexer->get_buffer(),
+                    parallel_ast,
+                    parallel_consumer,
+                    *source,
+                    ParserOptions{.jobs = 4});
+    parallel.parse();
+
+    ASSERT_EQ(parallel_ast.size(), ast.size());
+    for (size_t index = 1; index < ast.size(); ++index) {
+        auto expected = ast.get_node(index);
+        auto actual = parallel_ast.get_node(index);
+        EXPECT_EQ(parallel_ast.get_kind(actual), ast.get_kind(expected));
+        EXPECT_EQ(parallel_ast.get_spelling(actual), ast.get_spelling(expected));
+        EXPECT_EQ(parallel_ast.has_error(actual), ast.has_error(expected));
+
+        std::vector<size_t> expected_children;
+        for (auto child : ast.children(expected)) {
+            expected_children.push_back(child.get_index());
+        }
+        std::vector<size_t> actual_children;
+        for (auto child : parallel_ast.children(actual)) {
+            actual_children.push_back(child.get_index());
+        }
+        EXPECT_EQ(actual_children, expected_children);
+    }
+
+    EXPECT_FALSE(consumer->diagnostics().empty());
+    ASSERT_EQ(parallel_consumer->diagnostics().size(), consumer->diagnostics().size());
+    for (size_t i = 0; i < consumer->diagnostics().size(); ++i) {
+        EXPECT_EQ(parallel_consumer->diagnostics()[i].message, consumer->diagnostics()[i].message);
+        EXPECT_EQ(parallel_consumer->diagnostics()[i].location.line,
+                  consumer->diagnostics()[i].location.line);
+    }
+}
+
+TEST_F(ParserTest, ParallelParseKeepsModulesWhole) {
+    auto functions = [](llvm::StringRef prefix, size_t count) {
+        std::string text;
+        for (size_t i = 0; i < count; ++i) {
+            text += "fn " + prefix.str() + std::to_string(i) + "(a: int) -> int:\n    ret a * "
+                  + std::to_string(i) + "\n";
+        }
+        return text;
+    };
+    // The module holds most declarations, so split points fall inside it
+    parse(functions("before", 4) + "module shapes\n" + functions("inner", 32) + "end module\n"
+          + functions("after", 4));
+    ASSERT_TRUE(consumer->diagnostics().empty());
+
+    for (size_t jobs : {size_t{2}, size_t{4}, size_t{8}}) {
+        ast::AST parallel_ast;
+        auto parallel_consumer = std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*source);
+        Parser(lexer->get_buffer(), parallel_ast, parallel_consumer, *source, {.jobs = jobs})
+            .parse();
+        EXPECT_TRUE(same_tree(parallel_ast, parallel_ast.get_root(), ast, ast.get_root()))
+            << "jobs: " << jobs;
+        EXPECT_TRUE(parallel_consumer->diagnostics().empty()) << "jobs: " << jobs;
+    }
+}
+
+TEST_F(ParserTest, ParsedTreesAreLaidOut) {
+    std::string text;
+    for (size_t i = 0; i < 16; ++i) {
+        auto name = std::to_string(i);
+        text += "fn f" + name + "(a: int) -> int:\n    while a:\n        ret -(a + " + name
+              + ") * 2\n";
+        text += i % 4 == 0 ? "    ret a + b & c\n" : "    ret a\n";
+    }
+    parse(text);
+
+    for (size_t jobs : {size_t{1}, size_t{4}}) {
+        ast::AST laid_out;
+        Parser(lexer->get_buffer(), laid_out, consumer, *source, ParserOptions{.jobs = jobs})
+            .parse();
+        ASSERT_TRUE(laid_out.has_postorder_layout());
+        EXPECT_TRUE(same_tree(laid_out, laid_out.get_root(), ast, ast.get_root()));
+
+        // Every subtree is a contiguous run ending at its root, and children
+        // come before their parent
+        auto order = laid_out.postorder();
+        ASSERT_FALSE(order.empty());
+        EXPECT_EQ(order.back(), laid_out.get_root());
+        EXPECT_EQ(laid_out.get_subtree_size(laid_out.get_root()), order.size());
+        for (auto node : order) {
+            auto subtree = laid_out.postorder_subtree(node);
+            ASSERT_FALSE(subtree.empty());
+            EXPECT_EQ(subtree.back(), node);
+
+            size_t size = 1;
+            for (auto child : laid_out.children(node)) {
+                size += laid_out.get_subtree_size(child);
+                EXPECT_TRUE(llvm::is_contained(subtree, child));
+            }
+            EXPECT_EQ(subtree.size(), size);
+        }
+    }
+}
+
+TEST_F(ParserTest, TraversalOrders) {
+    parse("fn f(a: int) -> int:\n    if a:\n        ret a * 2\n    ret -a\n"
+          "fn g():\n    ret 1 + 2 + 3\n");
+
+    // Reference orders from a recursive walk, with each node's depth
+    std::vector<ast::AST::Node> preorder;
+    std::vector<ast::AST::Node> postorder;
+    std::vector<std::pair<size_t, ast::AST::Node>> by_depth;
+    auto walk = [&](auto& self, ast::AST::Node node, size_t depth) -> void {
+        preorder.push_back(node);
+        by_depth.push_back({depth, node});
+        for (auto child : ast.children(node)) {
+            self(self, child, depth + 1);
+        }
+        postorder.push_back(node);
+    };
+    walk(walk, ast.get_root(), 0);
+    std::stable_sort(by_depth.begin(), by_depth.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+    std::vector<ast::AST::Node> level_order;
+    for (const auto& [depth, node] : by_depth) {
+        level_order.push_back(node);
+    }
+
+    auto collect = [](auto range) {
+        return std::vector<ast::AST::Node>(range.begin(), range.end());
+    };
+    EXPECT_EQ(collect(ast.nodes()), postorder);
+    EXPECT_EQ(collect(ast.preorder(ast.get_root())), preorder);
+    EXPECT_EQ(collect(ast.level_order(ast.get_root())), level_order);
+
+    // Subtree walks stop at the subtree root
+    auto function = find_first(ast.get_root(), ast::NodeKind::FunctionDecl());
+    auto subtree = collect(ast.subtree(function));
+    ASSERT_FALSE(subtree.empty());
+    EXPECT_EQ(subtree.back(), function);
+    EXPECT_EQ(collect(ast.preorder(function)).front(), function);
+    EXPECT_EQ(collect(ast.preorder(function)).size(), subtree.size());
+    EXPECT_EQ(collect(ast.level_order(function)).size(), subtree.size());
+}
+
+TEST_F(ParserTest, ParallelSubtreeTraversal) {
+    std::string text;
+    for (size_t i = 0; i < 24; ++i) {
+        text += "fn f" + std::to_string(i) + "(a: int):\n";
+        for (size_t j = 0; j < i % 5 + 1; ++j) {
+            text += "    ret a * " + std::to_string(j) + " + 1\n";
+        }
+    }
+    parse(text);
+
+    auto is_function = [&](ast::AST::Node node) {
+        return ast.get_kind(node) == ast::NodeKind::FunctionDecl();
+    };
+    auto summarize = [&](ast::AST::Node node) {
+        auto nodes = ast.subtree(node);
+        return std::make_pair(ast.get_spelling(ast.get_first_child(node)).str(),
+                              static_cast<size_t>(std::distance(nodes.begin(), nodes.end())));
+    };
+
+    std::vector<std::pair<std::string, size_t>> expected;
+    for (auto node : ast.children(ast.get_root())) {
+        if (is_function(node)) {
+            expected.push_back(summarize(node));
+        }
+    }
+    ASSERT_EQ(expected.size(), 24u);
+
+    for (size_t jobs : {1, 4, 64}) {
+        auto results = ast.parallel_for_each_subtree(is_function, summarize, jobs);
+        EXPECT_TRUE(std::equal(results.begin(), results.end(), expected.begin(), expected.end()))
+            << "jobs: " << jobs;
+    }
+
+    // Matches are not searched for inside other matches
+    auto blocks = ast.parallel_for_each_subtree(
+        [&](ast::AST::Node node) {
+            return is_function(node) || ast.get_kind(node) == ast::NodeKind::CodeBlock();
+        },
+        [&](ast::AST::Node node) { return ast.get_kind(node); });
+    EXPECT_EQ(blocks.size(), 24u);
+}
+
+TEST_F(ParserTest, KindIndex) {
+    parse("fn f(a: int) -> int:\n    ret g(a) * 2\nfn g(b: int):\n    ret b\n");
+    EXPECT_TRUE(ast.get_nodes_of_kind(ast::NodeKind::FunctionDecl()).empty());
+
+    ast.build_kind_index();
+    ASSERT_TRUE(ast.has_kind_index());
+    for (auto kind : {ast::NodeKind::FunctionDecl(),
+                      ast::NodeKind::Parameter(),
+                      ast::NodeKind::ReturnStmt(),
+                      ast::NodeKind::FileEnd(),
+                      ast::NodeKind::ClassDecl()}) {
+        std::vector<ast::AST::Node> expected;
+        for (size_t index = 1; index < ast.size(); ++index) {
+            if (ast.get_kind(ast.get_node(index)) == kind) {
+                expected.push_back(ast.get_node(index));
+            }
+        }
+        auto nodes = ast.get_nodes_of_kind(kind);
+        EXPECT_EQ(std::vector<ast::AST::Node>(nodes.begin(), nodes.end()), expected);
+    }
+    EXPECT_EQ(ast.get_nodes_of_kind(ast::NodeKind::FunctionDecl()).size(), 2u);
+
+    ast.add_node(ast::NodeKind::FunctionDecl());
+    EXPECT_FALSE(ast.has_kind_index());
+}
+
+TEST_F(ParserTest, VisitorHooks) {
+    parse("fn f(a: int) -> int:\n    ret a * 2\nfn g():\n    ret 1 + 2\nfn h():\n    ret 3\n");
+
+    // Records hooks; skips the body of `g` and stops at the body of `h`
+    struct Recorder : ast::ASTVisitor<Recorder> {
+        const ast::AST& ast;
+        std::vector<std::string> events;
+
+        explicit Recorder(const ast::AST& tree) : ast(tree) {}
+
+        ast::VisitAction pre_visit_FunctionName(ast::AST::Node node) {
+            events.push_back("name " + ast.get_spelling(node).str());
+            return ast::VisitAction::Continue;
+        }
+        ast::VisitAction pre_visit_CodeBlock(ast::AST::Node node) {
+            auto name = ast.get_spelling(ast.get_first_child(ast.get_parent(node)));
+            if (name == "h") {
+                return ast::VisitAction::Stop;
+            }
+            return name == "g" ? ast::VisitAction::SkipChildren : ast::VisitAction::Continue;
+        }
+        void post_visit_BinaryExpr(ast::AST::Node node) {
+            events.push_back("binary " + ast.get_spelling(node).str());
+        }
+        void post_visit_FunctionDecl(ast::AST::Node /*node*/) {
+            events.push_back("end");
+        }
+    };
+
+    Recorder recorder(ast);
+    EXPECT_FALSE(recorder.traverse(ast, ast.get_root()));
+    EXPECT_EQ(recorder.events,
+              (std::vector<std::string>{"name f", "binary *", "end", "name g", "end", "name h"}));
+}
+
+TEST_F(ParserTest, SubtreeHashes) {
+    options.subtree_hashes = true;
+    parse("fn f(a: int):\n    ret a * 2\nfn g(a: int):\n    ret a * 2\n"
+          "fn h(a: int):\n    ret a * 3\n");
+    ASSERT_TRUE(ast.has_subtree_hashes());
+    EXPECT_NE(ast.get_subtree_hash(ast.get_root()), 0u);
+
+    std::vector<ast::AST::Node> blocks;
+    for (auto node : ast.preorder(ast.get_root())) {
+        if (ast.get_kind(node) == ast::NodeKind::CodeBlock()) {
+            blocks.push_back(node);
+        }
+    }
+    ASSERT_EQ(blocks.size(), 3u);
+    EXPECT_EQ(ast.get_subtree_hash(blocks[0]), ast.get_subtree_hash(blocks[1]));
+    EXPECT_NE(ast.get_subtree_hash(blocks[0]), ast.get_subtree_hash(blocks[2]));
+    EXPECT_TRUE(ast.is_same_subtree(blocks[0], ast, blocks[1]));
+    EXPECT_FALSE(ast.is_same_subtree(blocks[0], ast, blocks[2]));
+
+    // Hashes are the same across trees, and are dropped when links change
+    ast::AST reparsed;
+    Parser(lexer->get_buffer(), reparsed, consumer, *source, options).parse();
+    EXPECT_EQ(reparsed.get_subtree_hash(reparsed.get_root()), ast.get_subtree_hash(ast.get_root()));
+    EXPECT_TRUE(reparsed.is_same_subtree(reparsed.get_root(), ast, ast.get_root()));
+    reparsed.add_child(reparsed.get_root(), reparsed.add_node(ast::NodeKind::Comment()));
+    EXPECT_FALSE(reparsed.has_subtree_hashes());
+    EXPECT_FALSE(reparsed.is_same_subtree(reparsed.get_root(), ast, ast.get_root()));
+}
+
+TEST_F(ParserTest, SerializedTreeMatchesParsed) {
+    parse("fn f(a: int) -> int:\n    ret a * 2 + a\nfn g():\n    ret a & b | c\n");
+    ASSERT_TRUE(ast.has_error(ast.get_root()));
+
+    std::string bytes;
+    llvm::raw_string_ostream out(bytes);
+    ast::SerializedAST::write(ast, out);
+    out.flush();
+    fs.addFile("/test/input.zast", 0, llvm::MemoryBuffer::getMemBufferCopy(bytes));
+
+    auto loaded = ast::SerializedAST::from_file(fs, "/test/input.zast");
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->size(), ast.size());
+    EXPECT_EQ(loaded->get_token_count(), lexer->get_buffer().get_tokens().size());
+    EXPECT_EQ(loaded->get_filename(), "/test/input.ziv");
+    EXPECT_TRUE(same_tree(*loaded, loaded->get_root(), ast, ast.get_root()));
+    for (size_t index = 1; index < ast.size(); ++index) {
+        auto node = ast.get_node(index);
+        EXPECT_EQ(loaded->get_parent(node), ast.get_parent(node));
+        EXPECT_EQ(loaded->get_token_index(node), ast.get_token_index(node));
+    }
+
+    // Truncated, foreign and empty buffers are rejected
+    auto load = [](llvm::StringRef contents) {
+        return ast::SerializedAST::from_buffer(llvm::MemoryBuffer::getMemBufferCopy(contents));
+    };
+    EXPECT_FALSE(load(llvm::StringRef(bytes).drop_back()).has_value());
+    EXPECT_FALSE(load("ZIVC" + bytes.substr(4)).has_value());
+    EXPECT_FALSE(load("").has_value());
+}
+
+TEST_F(ParserTest, DumpFormats) {
+    parse("fn f(a: int) -> int:\n    ret g(a) * 2\n");
+    ast::Printer printer(ast);
+    auto dump = [&](ast::DumpFormat format) {
+        std::string text;
+        llvm::raw_string_ostream out(text);
+        printer.print(out, format);
+        return out.str();
+    };
+
+    // Every node gets a line named after its kind
+    const std::string tree = dump(ast::DumpFormat::Tree);
+    for (auto node : ast.nodes()) {
+        auto name = ast::Printer::get_kind_name(ast.get_kind(node));
+        EXPECT_NE(tree.find(name.str() + " (idx:" + std::to_string(node.get_index())),
+                  std::string::npos)
+            << name.str();
+    }
+
+    auto json = llvm::json::parse(dump(ast::DumpFormat::Json));
+    ASSERT_TRUE(static_cast<bool>(json));
+    auto* root = json->getAsObject()->getObject("root");
+    ASSERT_NE(root, nullptr);
+    auto kind = root->getString("kind");
+    ASSERT_TRUE(kind);
+    EXPECT_EQ(*kind, "FileStart");
+    EXPECT_EQ(root->getArray("children")->size(), children(ast.get_root()).size());
+
+    auto binary = ast::SerializedAST::from_buffer(
+        llvm::MemoryBuffer::getMemBufferCopy(dump(ast::DumpFormat::Binary)));
+    ASSERT_TRUE(binary.has_value());
+    EXPECT_TRUE(same_tree(*binary, binary->get_root(), ast, ast.get_root()));
+}
+
+TEST_F(ParserTest, SubtreeIntervals) {
+    parse("fn f(a: int) -> int:\n    if a:\n        ret a * 2\n    ret -a\nfn g():\n    ret 1\n");
+    ASSERT_TRUE(ast.has_postorder_layout());
+
+    auto walks_to = [&](ast::AST::Node ancestor, ast::AST::Node node) {
+        for (; node.is_valid(); node = ast.get_parent(node)) {
+            if (node == ancestor) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (auto ancestor : ast.nodes()) {
+        auto interval = ast.get_subtree_interval(ancestor);
+        ASSERT_TRUE(interval.has_value());
+        EXPECT_EQ(ast.postorder()[interval->exit], ancestor);
+        auto subtree = ast.subtree(ancestor);
+        EXPECT_TRUE(std::equal(subtree.begin(),
+                               subtree.end(),
+                               ast.postorder().begin() + interval->entry,
+                               ast.postorder().begin() + interval->exit + 1));
+        for (auto node : ast.nodes()) {
+            EXPECT_EQ(ast.is_ancestor(ancestor, node), walks_to(ancestor, node));
+        }
+    }
+
+    // An edge that would close a cycle is rejected without touching the layout
+    auto function = find_first(ast.get_root(), ast::NodeKind::FunctionDecl());
+    ast.add_child(find_first(function, ast::NodeKind::ReturnStmt()), function);
+    EXPECT_TRUE(ast.has_postorder_layout());
+    EXPECT_EQ(ast.get_parent(function), ast.get_root());
+
+    // Relinking drops the layout; ancestry is then found by walking
+    auto detached = ast.add_node(ast::NodeKind::Comment());
+    ast.add_child(function, detached);
+    EXPECT_FALSE(ast.has_postorder_layout());
+    EXPECT_FALSE(ast.get_subtree_interval(function).has_value());
+    EXPECT_TRUE(ast.is_ancestor(ast.get_root(), detached));
+    EXPECT_FALSE(ast.is_ancestor(detached, function));
+}
+
+TEST_F(ParserTest, CompactDropsUnreachableNodes) {
+    options.subtree_hashes = true;
+    parse("fn f(a: int) -> int:\n    ret (a * 2\nfn g():\n    ret a & b | c\n");
+    auto orphan = ast.add_node(ast::NodeKind::Comment());
+    ast.build_kind_index();
+
+    const ast::AST original = ast;
+    const size_t reachable = static_cast<size_t>(
+        std::distance(original.nodes().begin(), original.nodes().end()));
+    auto remap = ast.compact();
+
+    ASSERT_EQ(remap.size(), original.size());
+    EXPECT_EQ(ast.size(), reachable + 1);
+    EXPECT_FALSE(remap[orphan.get_index()].is_valid());
+    EXPECT_EQ(ast.get_root(), remap[original.get_root().get_index()]);
+    EXPECT_TRUE(same_tree(ast, ast.get_root(), original, original.get_root()));
+    EXPECT_TRUE(ast.is_same_subtree(ast.get_root(), original, original.get_root()));
+    EXPECT_EQ(ast.get_nodes_of_kind(ast::NodeKind::Comment()).size(), 0u);
+
+    for (auto node : original.nodes()) {
+        auto compacted = remap[node.get_index()];
+        ASSERT_TRUE(compacted.is_valid());
+        EXPECT_EQ(ast.get_kind(compacted), original.get_kind(node));
+        EXPECT_EQ(ast.get_subtree_hash(compacted), original.get_subtree_hash(node));
+    }
+    for (size_t span = 0; span < ast.get_declaration_spans().size(); ++span) {
+        const size_t node = original.get_declaration_spans()[span].node;
+        EXPECT_EQ(ast.get_declaration_spans()[span].node, node ? remap[node].get_index() : 0);
+    }
+}
+
+TEST_F(ParserTest, OutlineDefersFunctionBodies) {
+    options.outline = true;
+    parse("fn f(a: int) -> int:\n    if a:\n        ret a\n    ret 0\nfn g():\n    ret 1\n");
+
+    EXPECT_EQ(count(ast.get_root(), ast::NodeKind::FunctionDecl()), 2u);
+    EXPECT_EQ(count(ast.get_root(), ast::NodeKind::Placeholder()), 2u);
+    EXPECT_EQ(count(ast.get_root(), ast::NodeKind::CodeBlock()), 0u);
+    EXPECT_EQ(count(ast.get_root(), ast::NodeKind::ReturnStmt()), 0u);
+
+    auto function = find_first(ast.get_root(), ast::NodeKind::FunctionDecl());
+    auto placeholder = find_first(function, ast::NodeKind::Placeholder());
+    ASSERT_TRUE(placeholder.is_valid());
+
+    Parser body_parser(lexer->get_buffer(), ast, consumer, *source);
+    auto body = body_parser.parse_deferred_body(placeholder);
+    ASSERT_TRUE(body.is_valid());
+    EXPECT_EQ(ast.get_kind(body), ast::NodeKind::CodeBlock());
+    EXPECT_EQ(children(function).back(), body);
+    EXPECT_EQ(count(function, ast::NodeKind::ReturnStmt()), 2u);
+    EXPECT_EQ(count(ast.get_root(), ast::NodeKind::Placeholder()), 1u);
+    EXPECT_TRUE(consumer->diagnostics().empty());
+
+    // A body is only parsed once
+    EXPECT_FALSE(body_parser.parse_deferred_body(placeholder).is_valid());
+}
+
+TEST_F(ParserTest, ReparseReusesUntouchedDeclarations) {
+    auto make_text = [](llvm::StringRef edited_body) {
+        std::string text = "fn first(a: int):\n    ret a & b | c\n";
+        for (size_t i = 0; i < 16; ++i) {
+            auto name = std::to_string(i);
+            text += "fn f" + name + "(a: int):\n    if a:\n        ret a * " + name + "\n";
+            text += i == 8 ? edited_body.str() : "    ret a\n";
+        }
+        return text + "fn last(a: int):\n    ret a | b & c\n";
+    };
+    parse(make_text("    ret a\n"));
+
+    fs.addFile("/test/edited.ziv",
+               0,
+               llvm::MemoryBuffer::getMemBufferCopy(make_text("    ret a * 2 + 1\n")));
+    auto edited_source = source::SourceBuffer::from_file(fs, "/test/edited.ziv");
+    ASSERT_TRUE(edited_source.has_value());
+    auto edited_consumer = std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*edited_source);
+    lex::Lexer edited_lexer(*edited_source, edited_consumer);
+    diagnostics::DiagnosticContext::instance().reset();  // Errors from the first parse
+    edited_lexer.lex();
+
+    const auto first_node = ast.get_declaration_spans().front().node;
+    Parser(edited_lexer.get_buffer(), ast, edited_consumer, *edited_source)
+        .reparse(lexer->get_buffer());
+
+    ast::AST expected;
+    auto expected_consumer =
+        std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*edited_source);
+    Parser(edited_lexer.get_buffer(), expected, expected_consumer, *edited_source).parse();
+
+    EXPECT_TRUE(same_tree(ast, ast.get_root(), expected, expected.get_root()));
+    EXPECT_EQ(ast.get_declaration_spans().size(), expected.get_declaration_spans().size());
+
+    // The broken declarations around the edit kept their nodes and were not
+    // parsed again
+    EXPECT_EQ(ast.get_declaration_spans().front().node, first_node);
+    EXPECT_EQ(expected_consumer->diagnostics().size(), 2u);
+    EXPECT_TRUE(edited_consumer->diagnostics().empty());
+    EXPECT_TRUE(ast.has_error(ast.get_root()));
+}
+
+TEST_F(ParserTest, ReparseWorkDoesNotGrowWithUntouchedCode) {
+    options.subtree_hashes = true;
+    auto make_text = [](size_t untouched, llvm::StringRef edited_body) {
+        std::string text;
+        for (size_t i = 0; i < 2 * untouched + 1; ++i) {
+            auto name = std::to_string(i);
+            text += "fn f" + name + "(a: int):\n    if a:\n        ret a * " + name + "\n";
+            text += i == untouched ? edited_body.str() : "    ret a\n";
+        }
+        return text;
+    };
+
+    // Edits the function between `untouched` others on each side and returns
+    // the number of nodes reparsing added to the arena
+    auto reparse_growth = [&](size_t untouched) -> size_t {
+        const std::string path = "/test/" + std::to_string(untouched);
+        fs.addFile(path + ".ziv",
+                   0,
+                   llvm::MemoryBuffer::getMemBufferCopy(make_text(untouched, "    ret a\n")));
+        fs.addFile(path + "_edited.ziv",
+                   0,
+                   llvm::MemoryBuffer::getMemBufferCopy(
+                       make_text(untouched, "    ret a * 2 + 1\n")));
+        auto before_source = source::SourceBuffer::from_file(fs, path + ".ziv");
+        auto after_source = source::SourceBuffer::from_file(fs, path + "_edited.ziv");
+        auto before_consumer =
+            std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*before_source);
+        auto after_consumer =
+            std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*after_source);
+        lex::Lexer before_lexer(*before_source, before_consumer);
+        lex::Lexer after_lexer(*after_source, after_consumer);
+        before_lexer.lex();
+        after_lexer.lex();
+
+        ast::AST tree;
+        Parser(before_lexer.get_buffer(), tree, before_consumer, *before_source, options).parse();
+        const size_t size = tree.size();
+        const auto first_node = tree.get_declaration_spans()[0].node;
+        const auto last_node = tree.get_declaration_spans()[2 * untouched].node;
+        Parser(after_lexer.get_buffer(), tree, after_consumer, *after_source, options)
+            .reparse(before_lexer.get_buffer());
+
+        ast::AST expected;
+        Parser(after_lexer.get_buffer(), expected, after_consumer, *after_source, options).parse();
+        EXPECT_TRUE(same_tree(tree, tree.get_root(), expected, expected.get_root()));
+        EXPECT_EQ(tree.get_subtree_hash(tree.get_root()),
+                  expected.get_subtree_hash(expected.get_root()));
+        EXPECT_EQ(tree.get_declaration_spans()[0].node, first_node);
+        EXPECT_EQ(tree.get_declaration_spans()[2 * untouched].node, last_node);
+        EXPECT_TRUE(after_consumer->diagnostics().empty());
+
+        // The patched layout is the one laying the tree out again gives
+        std::vector<ast::AST::Node> postorder(tree.postorder().begin(), tree.postorder().end());
+        std::vector<size_t> sizes;
+        for (size_t index = 0; index < tree.size(); ++index) {
+            sizes.push_back(tree.get_subtree_size(tree.get_node(index)));
+        }
+        tree.layout_postorder();
+        EXPECT_TRUE(llvm::equal(postorder, tree.postorder()));
+        for (size_t index = 0; index < tree.size(); ++index) {
+            EXPECT_EQ(sizes[index], tree.get_subtree_size(tree.get_node(index)));
+        }
+
+        return tree.size() - size;
+    };
+
+    const size_t growth = reparse_growth(4);
+    EXPECT_GT(growth, 0u);
+    EXPECT_EQ(reparse_growth(64), growth);
+}
+
+}  // namespace ziv::toolchain::parser
@@ -0,0 +1,192 @@
+// Part of the Ziv Programming Language, under the Apache License v2.0 with LLVM
+// See /LICENSE for license details.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <gtest/gtest.h>
+
+#include "llvm/Support/VirtualFileSystem.h"
+#include "toolchain/diagnostics/diagnostic_consumer.hpp"
+#include "toolchain/lex/lexer.hpp"
+#include "toolchain/source/source_buffer.hpp"
+
+namespace ziv::toolchain::lex {
+
+class TokenBufferTest : public ::testing::Test {
+protected:
+    llvm::vfs::InMemoryFileSystem fs;
+
+    void SetUp() override {
+        diagnostics::DiagnosticContext::instance().reset();
+        fs.addFile("/test/lines.ziv",
+                   0,
+                   llvm::MemoryBuffer::getMemBuffer("let x = 1\n"
+                                                    "\n"
+                                                    "fn main():\n"
+                                                    "    ret x + 2\n"));
+        fs.addFile("/test/nested.ziv",
+                   0,
+                   llvm::MemoryBuffer::getMemBuffer("fn f(a: [int]):\n"
+                                                    "    if a:\n"
+                                                    "        g((a), {\n"
+                                                    "            b])\n"
+                                                    "    ret a\n"));
+        fs.addFile("/test/comments.ziv",
+                   0,
+                   llvm::MemoryBuffer::getMemBuffer("#-- spans\n"
+                                                    "two lines --#\n"
+                                                    "let y = 2  # trailing\n"));
+    }
+};
+
+TEST_F(TokenBufferTest, LineIndex) {
+    auto source = source::SourceBuffer::from_file(fs, "/test/lines.ziv");
+    ASSERT_TRUE(source.has_value());
+
+    auto consumer = std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*source);
+    Lexer lexer(*source, consumer);
+    lexer.lex();
+
+    const TokenBuffer& buffer = lexer.get_buffer();
+    const auto& tokens = buffer.get_tokens();
+    EXPECT_EQ(buffer.get_line_count(), 5u);
+
+    // Line 1 starts with the start-of-file marker.
+    EXPECT_EQ(buffer.get_first_token_on_line(1), 0u);
+    EXPECT_EQ(tokens[1].kind, TokenKind::Let());
+
+    // The empty line shares its first token with the line that follows it.
+    size_t fn_index = buffer.get_first_token_on_line(3);
+    EXPECT_EQ(buffer.get_first_token_on_line(2), fn_index);
+    EXPECT_TRUE(buffer.get_line_tokens(2).empty());
+
+    // The semicolon inserted for `let x = 1` belongs to the line that triggered it.
+    EXPECT_EQ(tokens[fn_index].kind, TokenKind::Semicolon());
+    EXPECT_EQ(tokens[fn_index + 1].kind, TokenKind::Fn());
+
+    auto line_four = buffer.get_line_tokens(4);
+    ASSERT_FALSE(line_four.empty());
+    EXPECT_EQ(line_four.front().kind, TokenKind::Indent());
+    EXPECT_EQ(line_four[1].kind, TokenKind::Return());
+    EXPECT_EQ(line_four.back().kind, TokenKind::IntLiteral());
+}
+
+TEST_F(TokenBufferTest, LineIndexCoversComments) {
+    auto source = source::SourceBuffer::from_file(fs, "/test/comments.ziv");
+    ASSERT_TRUE(source.has_value());
+
+    auto consumer = std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*source);
+    Lexer lexer(*source, consumer);
+    lexer.lex();
+
+    // Newlines inside comments start lines like any other.
+    const TokenBuffer& buffer = lexer.get_buffer();
+    EXPECT_EQ(buffer.get_line_count(), 4u);
+    auto line_three = buffer.get_line_tokens(3);
+    ASSERT_FALSE(line_three.empty());
+    EXPECT_EQ(line_three.front().kind, TokenKind::Let());
+    EXPECT_EQ(line_three.front().line, 3u);
+    EXPECT_EQ(line_three.front().column, 1u);
+}
+
+TEST_F(TokenBufferTest, TokenPositions) {
+    auto source = source::SourceBuffer::from_file(fs, "/test/lines.ziv");
+    ASSERT_TRUE(source.has_value());
+
+    auto consumer = std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*source);
+    Lexer lexer(*source, consumer);
+    lexer.lex();
+
+    // Line and column point at the first character of each token.
+    auto line_three = lexer.get_buffer().get_line_tokens(3);
+    ASSERT_GE(line_three.size(), 3u);
+    EXPECT_EQ(line_three[1].kind, TokenKind::Fn());
+    EXPECT_EQ(line_three[1].line, 3u);
+    EXPECT_EQ(line_three[1].column, 1u);
+    EXPECT_EQ(line_three[2].get_spelling(), "main");
+    EXPECT_EQ(line_three[2].column, 4u);
+
+    auto location = lexer.get_buffer().get_location(line_three[2].offset, 4);
+    EXPECT_EQ(location.line, 3u);
+    EXPECT_EQ(location.column, 4u);
+    EXPECT_EQ(location.file, "/test/lines.ziv");
+}
+
+TEST_F(TokenBufferTest, OffsetLookup) {
+    auto source = source::SourceBuffer::from_file(fs, "/test/lines.ziv");
+    ASSERT_TRUE(source.has_value());
+
+    auto consumer = std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*source);
+    Lexer lexer(*source, consumer);
+    lexer.lex();
+
+    const TokenBuffer& buffer = lexer.get_buffer();
+    const auto& tokens = buffer.get_tokens();
+    llvm::StringRef contents = source->get_contents();
+
+    EXPECT_EQ(buffer.get_line_for_offset(0), 1u);
+    EXPECT_EQ(buffer.get_line_for_offset(contents.find("fn")), 3u);
+    EXPECT_EQ(buffer.get_line_for_offset(contents.find("ret")), 4u);
+
+    // Every offset inside a token maps back to that token.
+    size_t main_offset = contents.find("main");
+    for (size_t offset = main_offset; offset < main_offset + 4; ++offset) {
+        const auto& token = tokens[buffer.get_token_at_offset(offset)];
+        EXPECT_EQ(token.kind, TokenKind::Identifier());
+        EXPECT_EQ(token.get_spelling(), "main");
+        EXPECT_EQ(token.offset, main_offset);
+    }
+
+    // Whitespace maps to the closest preceding token.
+    size_t plus_offset = contents.find('+');
+    EXPECT_EQ(tokens[buffer.get_token_at_offset(plus_offset + 1)].kind, TokenKind::Plus());
+
+    // Offsets past the end resolve to the end-of-file marker.
+    EXPECT_EQ(buffer.get_token_at_offset(contents.size() + 10), tokens.size() - 1);
+    EXPECT_EQ(tokens.back().kind, TokenKind::Eof());
+}
+
+TEST_F(TokenBufferTest, MatchingTokens) {
+    auto source = source::SourceBuffer::from_file(fs, "/test/nested.ziv");
+    ASSERT_TRUE(source.has_value());
+
+    auto consumer = std::make_shared<diagnostics::ConsoleDiagnosticConsumer>(*source);
+    Lexer lexer(*source, consumer);
+    lexer.lex();
+
+    const TokenBuffer& buffer = lexer.get_buffer();
+    const auto& tokens = buffer.get_tokens();
+
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        auto match = buffer.get_matching_token(i);
+        TokenKind kind = tokens[i].kind;
+
+        if (kind == TokenKind::LBrace() || (kind == TokenKind::RBracket() && tokens[i].line == 4)) {
+            // `{` is never closed and the following `]` has no opener.
+            EXPECT_FALSE(match.has_value());
+            continue;
+        }
+        if (kind == TokenKind::Indent() || kind == TokenKind::Dedent()
+            || kind == TokenKind::LParen() || kind == TokenKind::RParen()
+            || kind == TokenKind::LBracket() || kind == TokenKind::RBracket()) {
+            ASSERT_TRUE(match.has_value()) << "token " << i << " " << kind.get_name().str();
+            EXPECT_EQ(buffer.get_matching_token(*match), i);
+        } else {
+            EXPECT_FALSE(match.has_value());
+        }
+    }
+
+    // The function body's Indent matches the last Dedent before Eof.
+    size_t body = buffer.get_first_token_on_line(2);
+    ASSERT_EQ(tokens[body].kind, TokenKind::Indent());
+    EXPECT_EQ(buffer.get_matching_token(body), tokens.size() - 2);
+
+    // Parentheses that span an indented line still pair with each other.
+    size_t call = buffer.get_first_token_on_line(3) + 2;
+    ASSERT_EQ(tokens[call].kind, TokenKind::LParen());
+    auto close = buffer.get_matching_token(call);
+    ASSERT_TRUE(close.has_value());
+    EXPECT_EQ(tokens[*close].kind, TokenKind::RParen());
+    EXPECT_EQ(tokens[*close].line, 4u);
+}
+
+}  // namespace ziv::toolchain::lex
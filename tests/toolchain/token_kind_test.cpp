@@ -0,0 +1,64 @@
+// Part of the Ziv Programming Language, under the Apache License v2.0 with LLVM
+// See /LICENSE for license details.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <gtest/gtest.h>
+
+#include "toolchain/lex/token_kind.hpp"
+#include "toolchain/parser/operator_precedence.hpp"
+
+namespace ziv::toolchain::lex {
+
+// The property tables are usable in constant expressions.
+static_assert(TokenKind::Identifier().is_terminator());
+static_assert(!TokenKind::Colon().is_terminator());
+static_assert(TokenKind::Minus().is_unary_operator() && TokenKind::Minus().is_binary_operator());
+static_assert(TokenKind::Star().get_precedence_class() == PrecedenceClass::Multiplicative);
+
+TEST(TokenKindTest, Terminators) {
+    EXPECT_TRUE(TokenKind::RParen().is_terminator());
+    EXPECT_TRUE(TokenKind::Return().is_terminator());
+    EXPECT_TRUE(TokenKind::Increment().is_terminator());
+    EXPECT_FALSE(TokenKind::Plus().is_terminator());
+    EXPECT_FALSE(TokenKind::Indent().is_terminator());
+}
+
+TEST(TokenKindTest, Operators) {
+    EXPECT_TRUE(TokenKind::And().is_binary_operator());
+    EXPECT_FALSE(TokenKind::And().is_unary_operator());
+    EXPECT_TRUE(TokenKind::Not().is_unary_operator());
+    EXPECT_TRUE(TokenKind::Tilde().is_unary_operator());
+    EXPECT_FALSE(TokenKind::Identifier().is_binary_operator());
+
+    EXPECT_EQ(TokenKind::Plus().get_associativity(), Associativity::Left);
+    EXPECT_EQ(TokenKind::Pipe().get_associativity(), Associativity::None);
+    EXPECT_EQ(TokenKind::Less().get_precedence_class(), PrecedenceClass::Relational);
+    EXPECT_EQ(TokenKind::Comma().get_precedence_class(), PrecedenceClass::None);
+}
+
+TEST(TokenKindTest, ComparePrecedence) {
+    using parser::OperatorPrecedence;
+    using parser::Precedence;
+
+    EXPECT_EQ(OperatorPrecedence::compare_precedence(TokenKind::Star(), TokenKind::Plus()),
+              Precedence::LeftBindsTighter);
+    EXPECT_EQ(OperatorPrecedence::compare_precedence(TokenKind::Pipe(), TokenKind::Minus()),
+              Precedence::RightBindsTighter);
+    EXPECT_EQ(OperatorPrecedence::compare_precedence(TokenKind::Plus(), TokenKind::Minus()),
+              Precedence::LeftBindsTighter);
+    EXPECT_EQ(OperatorPrecedence::compare_precedence(TokenKind::And(), TokenKind::And()),
+              Precedence::LeftBindsTighter);
+
+    // Mixing classes without an agreed order requires parentheses.
+    EXPECT_EQ(OperatorPrecedence::compare_precedence(TokenKind::Pipe(), TokenKind::Caret()),
+              Precedence::Ambiguous);
+    EXPECT_EQ(OperatorPrecedence::compare_precedence(TokenKind::And(), TokenKind::Or()),
+              Precedence::Ambiguous);
+    EXPECT_EQ(OperatorPrecedence::compare_precedence(TokenKind::Plus(), TokenKind::Less()),
+              Precedence::Ambiguous);
+    EXPECT_EQ(OperatorPrecedence::compare_precedence(TokenKind::DoubleEquals(),
+                                                     TokenKind::NotEquals()),
+              Precedence::Ambiguous);
+}
+
+}  // namespace ziv::toolchain::lex
@@ -5,7 +5,9 @@
 #ifndef ZIV_TOOLCHAIN_AST_NODE_KIND_HPP
 #define ZIV_TOOLCHAIN_AST_NODE_KIND_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 
 #include "llvm/ADT/StringRef.h"
 
@@ -33,6 +35,23 @@ public:
 
     llvm::StringRef get_name() const;
 
+    static constexpr size_t KIND_COUNT = 0
+#define ZIV_NODE_KIND(NAME) +1
+#include "node_kind_registry.def"
+        ;
+
+    // Registry index of the kind, for storing kinds outside the process.
+    // Values follow the order of node_kind_registry.def.
+    constexpr uint8_t to_int() const {
+        return static_cast<uint8_t>(kind);
+    }
+    static constexpr std::optional<NodeKind> from_int(uint8_t value) {
+        if (value >= KIND_COUNT) {
+            return std::nullopt;
+        }
+        return NodeKind(static_cast<KindEnum>(value));
+    }
+
 private:
     enum class KindEnum : uint8_t {
 #define ZIV_NODE_KIND(NAME) NAME,
@@ -4,86 +4,178 @@
 
 #include "printer.hpp"
 
-#include <map>
+#include <array>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/JSON.h"
+#include "serialization.hpp"
 
 namespace ziv::toolchain::ast {
 
-const llvm::StringRef Printer::get_kind_name(NodeKind kind) {
-    // Use a map for lookup since we can't convert NodeKind to size_t directly
-    static const std::map<NodeKind, llvm::StringRef> kind_names = {
-        {NodeKind::FileStart(), "FileStart"},
-        {NodeKind::FileEnd(), "FileEnd"},
-        {NodeKind::Invalid(), "Invalid"},
-        {NodeKind::Placeholder(), "Placeholder"},
-        {NodeKind::TranslationUnit(), "TranslationUnit"},
-        {NodeKind::ModuleDecl(), "ModuleDecl"},
-        {NodeKind::ModuleName(), "ModuleName"},
-        {NodeKind::ModuleImport(), "ModuleImport"},
-        {NodeKind::ModuleAlias(), "ModuleAlias"},
-        {NodeKind::ModuleImportList(), "ModuleImportList"},
-        {NodeKind::ModuleImportItem(), "ModuleImportItem"},
-        {NodeKind::VarDecl(), "VariableDecl"},
-        {NodeKind::VariableName(), "VariableName"},
-        {NodeKind::VariableInit(), "VariableInit"},
-        {NodeKind::TypeSpec(), "TypeSpec"},
-        {NodeKind::FunctionDecl(), "FunctionDecl"},
-        {NodeKind::FunctionName(), "FunctionName"},
-        {NodeKind::FunctionSignature(), "FunctionSignature"},
-        {NodeKind::FunctionBody(), "FunctionBody"},
-        {NodeKind::StructDecl(), "StructDecl"},
-        {NodeKind::ClassDecl(), "ClassDecl"},
-        {NodeKind::EnumDecl(), "EnumDecl"},
-        {NodeKind::MethodDecl(), "MethodDecl"},
-        {NodeKind::ParameterList(), "ParameterList"},
-        {NodeKind::Parameter(), "Parameter"},
-        {NodeKind::ArgumentList(), "ArgumentList"},
-        {NodeKind::Argument(), "Argument"},
-        {NodeKind::StatementList(), "StatementList"},
-        {NodeKind::CodeBlock(), "CodeBlock"},
-        {NodeKind::ReturnStmt(), "ReturnStatement"},
-        {NodeKind::IfStatement(), "IfStatement"},
-        {NodeKind::ElseStatement(), "ElseStatement"},
-        {NodeKind::WhileLoop(), "WhileLoop"},
-        {NodeKind::DoWhileLoop(), "DoWhileLoop"},
-        {NodeKind::ForLoop(), "ForLoop"},
-        {NodeKind::MatchStmt(), "MatchStatement"},
-        {NodeKind::CaseStmt(), "CaseStatement"},
-        {NodeKind::BreakStmt(), "BreakStatement"},
-        {NodeKind::ContinueStmt(), "ContinueStatement"},
-        {NodeKind::ArrayExpr(), "ArrayExpr"},
-        {NodeKind::LiteralExpr(), "LiteralExpr"},
-        {NodeKind::BinaryExpr(), "BinaryExpr"},
-        {NodeKind::UnaryExpr(), "UnaryExpr"},
-        {NodeKind::CallExpr(), "CallExpr"},
-        {NodeKind::IndexExpr(), "IndexExpr"},
-        {NodeKind::IdentifierExpr(), "IdentifierExpr"},
-        {NodeKind::FieldDecl(), "FieldDecl"},
-        {NodeKind::MethodList(), "MethodList"},
-        {NodeKind::FieldList(), "FieldList"},
-        {NodeKind::Error(), "Error"},
-        {NodeKind::Comment(), "Comment"},
+namespace {
+
+// Registry names, except where dumps have always spelled a kind out
+constexpr std::array<llvm::StringRef, NodeKind::KIND_COUNT> KIND_NAMES = [] {
+    std::array<llvm::StringRef, NodeKind::KIND_COUNT> names{
+#define ZIV_NODE_KIND(NAME) #NAME,
+#include "node_kind_registry.def"
     };
+    names[NodeKind::VarDecl().to_int()] = "VariableDecl";
+    names[NodeKind::ReturnStmt().to_int()] = "ReturnStatement";
+    names[NodeKind::MatchStmt().to_int()] = "MatchStatement";
+    names[NodeKind::CaseStmt().to_int()] = "CaseStatement";
+    names[NodeKind::BreakStmt().to_int()] = "BreakStatement";
+    names[NodeKind::ContinueStmt().to_int()] = "ContinueStatement";
+    return names;
+}();
+
+bool has_value_spelling(lex::TokenKind kind) {
+    return kind == lex::TokenKind::Identifier() || kind == lex::TokenKind::StringLiteral()
+        || kind == lex::TokenKind::IntLiteral() || kind == lex::TokenKind::FloatLiteral()
+        || kind == lex::TokenKind::CharLiteral();
+}
+
+void write_string(llvm::json::OStream& json, llvm::StringRef key, llvm::StringRef value) {
+    // String literals may hold bytes that are not UTF-8, which JSON can't
+    if (llvm::json::isUTF8(value)) {
+        json.attribute(key, value);
+    } else {
+        json.attribute(key, llvm::json::fixUTF8(value));
+    }
+}
+
+}  // namespace
 
-    auto it = kind_names.find(kind);
-    return it != kind_names.end() ? it->second : "Unknown";
+llvm::StringRef Printer::get_kind_name(NodeKind kind) {
+    return KIND_NAMES[kind.to_int()];
 }
 
-void Printer::print_indentation(llvm::raw_ostream& os,
-                                size_t indent,
-                                const std::vector<bool>& last_child) const {
-    // We need to print indentation up to indent level
-    for (size_t i = 0; i < indent; ++i) {
-        // If we're within the last_child vector bounds
-        if (i < last_child.size()) {
-            // Use previous levels to determine if we print "│  " or "   "
-            os << (last_child[i] ? "   " : "│  ");
-        } else {
-            // Default to "   " if we're beyond last_child bounds
-            os << "   ";
+void Printer::print(llvm::raw_ostream& os) const {
+    print_tree(os);
+}
+
+void Printer::print(llvm::raw_ostream& os, DumpFormat format) const {
+    switch (format) {
+        case DumpFormat::Tree:
+            print_tree(os);
+            break;
+        case DumpFormat::Json:
+            print_json(os);
+            break;
+        case DumpFormat::Binary:
+            SerializedAST::write(ast_, os);
+            break;
+    }
+}
+
+void Printer::print_tree(llvm::raw_ostream& os) const {
+    os << "AST Structure ";
+    if (ast_.empty()) {
+        os << "(empty)\n";
+        return;
+    }
+    os << "(" << ast_.size() << " nodes):\n";
+
+    // One frame per node whose children are being printed: the next child
+    // and the length of the guides drawn in front of the children
+    struct Frame {
+        AST::Node next_child;
+        size_t prefix_size;
+    };
+    llvm::SmallVector<Frame, 32> frames;
+    llvm::SmallString<128> prefix;
+
+    auto print_line = [&](AST::Node node, bool is_last) {
+        os << prefix << (is_last ? "└─ " : "├─ ");
+        print_node_header(os, node);
+
+        prefix += is_last ? "   " : "│  ";
+        const AST::Node first_child = ast_.get_first_child(node);
+        if (!first_child.is_valid() || !options_.compact_mode) {
+            print_node_details(os, node, prefix, first_child.is_valid());
+        }
+        os << "\n";
+        frames.push_back({first_child, prefix.size()});
+    };
+
+    print_line(ast_.get_root(), true);
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        const AST::Node child = frame.next_child;
+        if (!child.is_valid()) {
+            frames.pop_back();
+            continue;
         }
+        frame.next_child = ast_.get_next_sibling(child);
+        prefix.resize(frame.prefix_size);
+        const bool is_last = !frame.next_child.is_valid();
+        print_line(child, is_last);
     }
 }
 
+void Printer::print_json(llvm::raw_ostream& os) const {
+    llvm::json::OStream json(os);
+
+    // One frame per open node object: the next child to write and whether
+    // a children array was opened
+    struct Frame {
+        AST::Node next_child;
+        bool has_children;
+    };
+    llvm::SmallVector<Frame, 32> frames;
+
+    auto begin_node = [&](AST::Node node) {
+        json.objectBegin();
+        json.attribute("kind", get_kind_name(ast_.get_kind(node)));
+        json.attribute("index", static_cast<int64_t>(node.get_index()));
+        if (ast_.get_token_index(node) != AST::NO_TOKEN) {
+            const auto& token = ast_.get_token(node);
+            json.attribute("token", token.get_name());
+            write_string(json, "spelling", token.get_spelling());
+            json.attribute("line", static_cast<int64_t>(token.get_line()));
+            json.attribute("column", static_cast<int64_t>(token.get_column()));
+        }
+        if (ast_.has_error(node)) {
+            json.attribute("error", true);
+        }
+
+        const AST::Node first_child = ast_.get_first_child(node);
+        if (first_child.is_valid()) {
+            json.attributeBegin("children");
+            json.arrayBegin();
+        }
+        frames.push_back({first_child, first_child.is_valid()});
+    };
+
+    json.objectBegin();
+    json.attribute("nodes", static_cast<int64_t>(ast_.size()));
+    json.attributeBegin("root");
+    if (ast_.empty()) {
+        json.value(nullptr);
+    } else {
+        begin_node(ast_.get_root());
+    }
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        const AST::Node child = frame.next_child;
+        if (child.is_valid()) {
+            frame.next_child = ast_.get_next_sibling(child);
+            begin_node(child);
+            continue;
+        }
+
+        if (frame.has_children) {
+            json.arrayEnd();
+            json.attributeEnd();
+        }
+        json.objectEnd();
+        frames.pop_back();
+    }
+    json.attributeEnd();
+    json.objectEnd();
+    os << "\n";
+}
+
 void Printer::print_node_header(llvm::raw_ostream& os, AST::Node node) const {
     os << get_kind_name(ast_.get_kind(node));
 
@@ -104,85 +196,29 @@ void Printer::print_node_header(llvm::raw_ostream& os, AST::Node node) const {
 
 void Printer::print_node_details(llvm::raw_ostream& os,
                                  AST::Node node,
-                                 size_t indent,
-                                 const std::vector<bool>& last_child) const {
-    if (!options_.show_token_info)
+                                 llvm::StringRef prefix,
+                                 bool has_children) const {
+    if (!options_.show_token_info) {
         return;
+    }
 
     const auto& token = ast_.get_token(node);
-    auto token_kind = token.get_kind();
-
-    std::vector<bool> child_prefix = last_child;
-    child_prefix.push_back(true);  // Always true for details
+    const auto token_kind = token.get_kind();
+    const llvm::StringRef guide = has_children ? "│  " : "   ";
 
-    // First print the token kind
-    os << "\n";
-    print_indentation(os, indent + 1, child_prefix);
-    os << "└─ Token: '" << token.get_name() << "'";
+    os << "\n" << prefix << guide << "Token: '" << token.get_name() << "'";
 
     // For literals and identifiers, print their actual value
-    if (token_kind == lex::TokenKind::Identifier() || token_kind == lex::TokenKind::StringLiteral()
-        || token_kind == lex::TokenKind::IntLiteral()
-        || token_kind == lex::TokenKind::FloatLiteral()
-        || token_kind == lex::TokenKind::CharLiteral()) {
-        os << "\n";
-        print_indentation(os, indent + 1, child_prefix);
-        os << "└─ Value: '" << token.get_spelling() << "'";
+    if (has_value_spelling(token_kind)) {
+        os << "\n" << prefix << guide << "Value: '" << token.get_spelling() << "'";
     }
     // For keywords, only print the spelling if it differs from the name
     else if (token_kind.is_keyword()) {
         const auto spelling = token.get_spelling();
         if (spelling != token.get_name()) {
-            os << "\n";
-            print_indentation(os, indent + 1, child_prefix);
-            os << "└─ Spelling: '" << spelling << "'";
+            os << "\n" << prefix << guide << "Spelling: '" << spelling << "'";
         }
     }
 }
 
-void Printer::print_node(llvm::raw_ostream& os,
-                         AST::Node node,
-                         size_t indent,
-                         std::vector<bool> last_child) const {
-    if (!node.is_valid()) {
-        print_indentation(os, indent, last_child);
-        os << "└─ Invalid Node\n";
-        return;
-    }
-
-    print_indentation(os, indent, last_child);
-
-    // Determine connector based on position
-    if (indent == 0) {
-        os << "└─ ";  // Root node
-    } else {
-        os << (last_child.back() ? "└─ " : "├─ ");
-    }
-
-    print_node_header(os, node);
-
-    auto children = ast_.children(node);
-    auto child_count = std::distance(children.begin(), children.end());
-
-    if (child_count > 0) {
-        if (!options_.compact_mode) {
-            print_node_details(os, node, indent, last_child);
-        }
-        os << "\n";
-
-        size_t current_child = 0;
-        for (const auto& child : children) {
-            current_child++;
-            bool is_last = (current_child == child_count);
-
-            auto child_last = last_child;
-            child_last.push_back(is_last);
-            print_node(os, child, indent + 1, child_last);
-        }
-    } else {
-        print_node_details(os, node, indent, last_child);
-        os << "\n";
-    }
-}
-
 }  // namespace ziv::toolchain::ast
@@ -5,8 +5,7 @@
 #ifndef ZIV_TOOLCHAIN_AST_PRINTER_HPP
 #define ZIV_TOOLCHAIN_AST_PRINTER_HPP
 
-#include <optional>
-#include <vector>
+#include <cstdint>
 
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
@@ -16,6 +15,16 @@
 
 namespace ziv::toolchain::ast {
 
+// Output formats of Printer::print()
+enum class DumpFormat : uint8_t {
+    Tree,    // Indented tree for reading
+    Json,    // Nested JSON objects, one per node
+    Binary,  // The .zast format of SerializedAST
+};
+
+// Prints trees without recursion, so dumps are linear in the number of nodes
+// whatever their depth. The tree format builds each line's guides in one
+// prefix buffer shared by all lines.
 class Printer {
 public:
     struct PrintOptions {
@@ -38,34 +47,23 @@ public:
     explicit Printer(const AST& ast, PrintOptions options = PrintOptions{})
         : ast_(ast), options_(options) {}
 
-    void print(llvm::raw_ostream& os) const {
-        os << "AST Structure ";
-        if (ast_.empty()) {
-            os << "(empty)\n";
-            return;
-        }
-        os << "(" << ast_.size() << " nodes):\n";
-        print_node(os, ast_.get_root(), 0, {});
-    }
+    void print(llvm::raw_ostream& os) const;
+    void print(llvm::raw_ostream& os, DumpFormat format) const;
 
-    static const llvm::StringRef get_kind_name(NodeKind kind);
+    static llvm::StringRef get_kind_name(NodeKind kind);
 
 private:
-    void print_indentation(llvm::raw_ostream& os,
-                           size_t indent,
-                           const std::vector<bool>& last_child) const;
+    void print_tree(llvm::raw_ostream& os) const;
+    void print_json(llvm::raw_ostream& os) const;
 
     void print_node_header(llvm::raw_ostream& os, AST::Node node) const;
 
+    // Prints token lines below the header of `node`, whose children are
+    // drawn with `prefix`
     void print_node_details(llvm::raw_ostream& os,
                             AST::Node node,
-                            size_t indent,
-                            const std::vector<bool>& last_child) const;
-
-    void print_node(llvm::raw_ostream& os,
-                    AST::Node node,
-                    size_t indent,
-                    std::vector<bool> last_child) const;
+                            llvm::StringRef prefix,
+                            bool has_children) const;
 
     const AST& ast_;
     PrintOptions options_;
@@ -0,0 +1,262 @@
+// Part of the Ziv Programming Language, under the Apache License v2.0 with LLVM
+// See /LICENSE for license details.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "serialization.hpp"
+
+#include <cstring>
+#include <string>
+
+#include "llvm/ADT/StringMap.h"
+
+namespace ziv::toolchain::ast {
+
+namespace {
+
+constexpr char MAGIC[4] = {'Z', 'A', 'S', 'T'};
+
+void write_word(llvm::raw_ostream& out, uint32_t value) {
+    const char bytes[] = {static_cast<char>(value & 0xff),
+                          static_cast<char>((value >> 8) & 0xff),
+                          static_cast<char>((value >> 16) & 0xff),
+                          static_cast<char>((value >> 24) & 0xff)};
+    out.write(bytes, sizeof(bytes));
+}
+
+void write_padding(llvm::raw_ostream& out, size_t size) {
+    for (; size % 4 != 0; ++size) {
+        out << '\0';
+    }
+}
+
+uint64_t align_to_word(uint64_t size) {
+    return (size + 3) & ~uint64_t{3};
+}
+
+}  // namespace
+
+void SerializedAST::write(const AST& ast, llvm::raw_ostream& out) {
+    const auto node_count = static_cast<uint32_t>(ast.size());
+    llvm::ArrayRef<AST::Token> tokens = ast.get_tokens();
+
+    // Tokens are stored with the spelling AST::get_spelling() reports.
+    // Spellings are interned, so repeated identifiers and literals are
+    // stored once.
+    std::string strings = tokens.empty() ? std::string() : tokens.front().filename.str();
+    const auto filename_size = static_cast<uint32_t>(strings.size());
+    llvm::StringMap<uint32_t> spelling_offsets;
+    llvm::SmallVector<uint32_t, 0> token_spellings;
+    token_spellings.reserve(tokens.size());
+    for (const AST::Token& token : tokens) {
+        llvm::StringRef spelling = token.get_spelling();
+        auto [entry, inserted] =
+            spelling_offsets.try_emplace(spelling, static_cast<uint32_t>(strings.size()));
+        if (inserted) {
+            strings += spelling;
+        }
+        token_spellings.push_back(entry->second);
+    }
+
+    out.write(MAGIC, sizeof(MAGIC));
+    write_word(out, VERSION);
+    write_word(out, static_cast<uint32_t>(NodeKind::KIND_COUNT));
+    write_word(out, static_cast<uint32_t>(lex::TokenKind::KIND_COUNT));
+    write_word(out, node_count);
+    write_word(out, static_cast<uint32_t>(tokens.size()));
+    write_word(out, filename_size);
+    write_word(out, static_cast<uint32_t>(strings.size()));
+
+    for (uint32_t index = 0; index < node_count; ++index) {
+        out << static_cast<char>(ast.get_kind(Node(index)).to_int());
+    }
+    write_padding(out, node_count);
+    for (uint32_t index = 0; index < node_count; ++index) {
+        write_word(out, ast.get_token_index(Node(index)));
+    }
+    for (uint32_t index = 0; index < node_count; ++index) {
+        write_word(out, static_cast<uint32_t>(ast.get_parent(Node(index)).get_index()));
+    }
+    for (uint32_t index = 0; index < node_count; ++index) {
+        write_word(out, static_cast<uint32_t>(ast.get_first_child(Node(index)).get_index()));
+    }
+    for (uint32_t index = 0; index < node_count; ++index) {
+        write_word(out, static_cast<uint32_t>(ast.get_next_sibling(Node(index)).get_index()));
+    }
+    for (uint32_t base = 0; base < node_count; base += 32) {
+        uint32_t word = 0;
+        for (uint32_t bit = 0; bit < 32 && base + bit < node_count; ++bit) {
+            word |= static_cast<uint32_t>(ast.has_error(Node(base + bit))) << bit;
+        }
+        write_word(out, word);
+    }
+
+    for (size_t index = 0; index < tokens.size(); ++index) {
+        const AST::Token& token = tokens[index];
+        write_word(out, static_cast<uint32_t>(static_cast<int>(token.kind)));
+        write_word(out, token_spellings[index]);
+        write_word(out, static_cast<uint32_t>(token.get_spelling().size()));
+        write_word(out, static_cast<uint32_t>(token.line));
+        write_word(out, static_cast<uint32_t>(token.column));
+        write_word(out, static_cast<uint32_t>(token.offset));
+    }
+    out << strings;
+}
+
+std::optional<SerializedAST> SerializedAST::from_file(llvm::vfs::FileSystem& fs,
+                                                      llvm::StringRef filename) {
+    llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> file = fs.openFileForRead(filename);
+
+    if (!file) {
+        return std::nullopt;  // File not found
+    }
+
+    llvm::ErrorOr<llvm::vfs::Status> status = (*file)->status();
+
+    if (!status || !status->isRegularFile()) {
+        return std::nullopt;  // Only regular files can be mapped
+    }
+
+    // Without a null terminator the buffer can be a mapping of the file
+    auto buffer = (*file)->getBuffer(filename,
+                                     static_cast<int64_t>(status->getSize()),
+                                     /*RequiresNullTerminator=*/false);
+
+    if (!buffer) {
+        return std::nullopt;  // Could not read file into memory buffer
+    }
+
+    return from_buffer(std::move(*buffer));
+}
+
+std::optional<SerializedAST>
+SerializedAST::from_buffer(std::unique_ptr<llvm::MemoryBuffer> buffer) {
+    // Sections are read in place, so their entries must not be padded
+    static_assert(sizeof(Header) == 8 * sizeof(Word) && sizeof(TokenEntry) == 6 * sizeof(Word));
+
+    llvm::StringRef contents = buffer->getBuffer();
+    if (contents.size() < sizeof(Header)) {
+        return std::nullopt;  // Truncated header
+    }
+
+    const auto* header = reinterpret_cast<const Header*>(contents.data());
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION) {
+        return std::nullopt;  // Not a .zast file, or written by another version
+    }
+    if (header->node_kind_count != NodeKind::KIND_COUNT
+        || header->token_kind_count != lex::TokenKind::KIND_COUNT) {
+        return std::nullopt;  // Kinds were numbered by a different registry
+    }
+
+    const uint64_t node_count = header->node_count;
+    const uint64_t token_count = header->token_count;
+    const uint64_t strings_size = header->strings_size;
+    const uint64_t expected_size = sizeof(Header) + align_to_word(node_count)
+                                 + 4 * sizeof(Word) * node_count
+                                 + sizeof(Word) * ((node_count + 31) / 32)
+                                 + sizeof(TokenEntry) * token_count + strings_size;
+    if (node_count == 0 || contents.size() != expected_size
+        || header->filename_size > strings_size) {
+        return std::nullopt;  // Section sizes do not match the header
+    }
+
+    SerializedAST ast(std::move(buffer));
+    const char* cursor = contents.data() + sizeof(Header);
+    auto take_words = [&cursor](uint64_t count) {
+        llvm::ArrayRef<Word> words(reinterpret_cast<const Word*>(cursor), count);
+        cursor += sizeof(Word) * count;
+        return words;
+    };
+
+    ast.kinds_ = llvm::ArrayRef<uint8_t>(reinterpret_cast<const uint8_t*>(cursor), node_count);
+    cursor += align_to_word(node_count);
+    ast.token_indices_ = take_words(node_count);
+    ast.parents_ = take_words(node_count);
+    ast.first_children_ = take_words(node_count);
+    ast.next_siblings_ = take_words(node_count);
+    ast.errors_ = take_words((node_count + 31) / 32);
+    ast.tokens_ = llvm::ArrayRef<TokenEntry>(reinterpret_cast<const TokenEntry*>(cursor),
+                                             token_count);
+    cursor += sizeof(TokenEntry) * token_count;
+    ast.strings_ = llvm::StringRef(cursor, strings_size);
+    ast.filename_ = ast.strings_.take_front(header->filename_size);
+    return ast;
+}
+
+NodeKind SerializedAST::get_kind(Node node) const noexcept {
+    if (!is_valid_node(node)) {
+        return NodeKind::Invalid();
+    }
+    return NodeKind::from_int(kinds_[node.get_index()]).value_or(NodeKind::Invalid());
+}
+
+SerializedAST::TokenIndex SerializedAST::get_token_index(Node node) const noexcept {
+    return is_valid_node(node) ? TokenIndex(token_indices_[node.get_index()]) : AST::NO_TOKEN;
+}
+
+llvm::StringRef SerializedAST::get_spelling(Node node) const noexcept {
+    return get_token_spelling(get_token_index(node));
+}
+
+source::SourceLocation SerializedAST::get_location(Node node) const noexcept {
+    return get_token_location(get_token_index(node));
+}
+
+bool SerializedAST::has_error(Node node) const noexcept {
+    if (!is_valid_node(node)) {
+        return false;
+    }
+    const size_t index = node.get_index();
+    return ((errors_[index / 32] >> (index % 32)) & 1) != 0;
+}
+
+SerializedAST::Node SerializedAST::get_link(llvm::ArrayRef<Word> links,
+                                            Node node) const noexcept {
+    if (!is_valid_node(node)) {
+        return Node();
+    }
+    const uint32_t link = links[node.get_index()];
+    return link < size() ? Node(link) : Node();
+}
+
+SerializedAST::Node SerializedAST::get_parent(Node node) const noexcept {
+    return get_link(parents_, node);
+}
+
+SerializedAST::Node SerializedAST::get_first_child(Node node) const noexcept {
+    return get_link(first_children_, node);
+}
+
+SerializedAST::Node SerializedAST::get_next_sibling(Node node) const noexcept {
+    return get_link(next_siblings_, node);
+}
+
+llvm::iterator_range<SerializedAST::ChildIterator>
+SerializedAST::children(Node node) const noexcept {
+    return llvm::make_range(ChildIterator(this, get_first_child(node)),
+                            ChildIterator(this, Node()));
+}
+
+lex::TokenKind SerializedAST::get_token_kind(TokenIndex index) const noexcept {
+    if (index >= tokens_.size() || tokens_[index].kind >= lex::TokenKind::KIND_COUNT) {
+        return lex::TokenKind::Sof();
+    }
+    return *lex::TokenKind::from_int(static_cast<int>(tokens_[index].kind));
+}
+
+llvm::StringRef SerializedAST::get_token_spelling(TokenIndex index) const noexcept {
+    if (index >= tokens_.size()) {
+        return "";
+    }
+    return strings_.substr(tokens_[index].spelling_offset, tokens_[index].spelling_size);
+}
+
+source::SourceLocation SerializedAST::get_token_location(TokenIndex index) const noexcept {
+    // Like AST::get_location(), nodes without a token have an empty location
+    if (index >= tokens_.size()) {
+        return {"", 0, 0, 0, 0};
+    }
+    const TokenEntry& token = tokens_[index];
+    return {filename_, token.line, token.column, token.offset, token.spelling_size};
+}
+
+}  // namespace ziv::toolchain::ast
@@ -0,0 +1,170 @@
+// Part of the Ziv Programming Language, under the Apache License v2.0 with LLVM
+// See /LICENSE for license details.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef ZIV_TOOLCHAIN_AST_SERIALIZATION_HPP
+#define ZIV_TOOLCHAIN_AST_SERIALIZATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/iterator.h"
+#include "llvm/ADT/iterator_range.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include "toolchain/ast/node_kind.hpp"
+#include "toolchain/ast/tree.hpp"
+#include "toolchain/lex/token_kind.hpp"
+#include "toolchain/source/source_location.hpp"
+
+namespace ziv::toolchain::ast {
+
+// Read-only view of a tree stored in the `.zast` format, which holds the node
+// columns of an AST together with the tokens they refer to:
+//
+//   header       magic "ZAST", format version, registry sizes, counts
+//   kinds        one byte per node, padded to four bytes
+//   tokens       token index per node
+//   parents      parent index per node
+//   children     first child index per node
+//   siblings     next sibling index per node
+//   errors       error bits, 32 nodes per word
+//   token table  kind, spelling offset and size, line, column, offset
+//   strings      file name followed by the interned token spellings
+//
+// Integers are 32-bit little endian. The view reads the columns in place, so
+// loading maps the file and checks the section sizes, and nodes are only
+// decoded when they are accessed. Accessors check bounds, so a corrupt file
+// reads as a wrong tree rather than outside the buffer.
+class SerializedAST {
+public:
+    using Node = NodeId;
+    using TokenIndex = AST::TokenIndex;
+    class ChildIterator;
+
+    static constexpr uint32_t VERSION = 1;
+
+    // Writes `ast` and the tokens it refers to. Trees are written as they
+    // are, including nodes not reachable from the root.
+    static void write(const AST& ast, llvm::raw_ostream& out);
+
+    static std::optional<SerializedAST> from_file(llvm::vfs::FileSystem& fs,
+                                                  llvm::StringRef filename);
+    static std::optional<SerializedAST> from_buffer(std::unique_ptr<llvm::MemoryBuffer> buffer);
+
+    SerializedAST() = delete;
+
+    [[nodiscard]] size_t size() const noexcept {
+        return kinds_.size();
+    }
+    [[nodiscard]] Node get_root() const noexcept {
+        return size() > 1 ? Node(1) : Node();
+    }
+    [[nodiscard]] llvm::StringRef get_filename() const noexcept {
+        return filename_;
+    }
+
+    // Node property accessors; invalid nodes read as Invalid without a token
+    [[nodiscard]] NodeKind get_kind(Node node) const noexcept;
+    [[nodiscard]] TokenIndex get_token_index(Node node) const noexcept;
+    [[nodiscard]] llvm::StringRef get_spelling(Node node) const noexcept;
+    [[nodiscard]] source::SourceLocation get_location(Node node) const noexcept;
+    [[nodiscard]] bool has_error(Node node) const noexcept;
+
+    // Structure accessors; each returns an invalid node where there is none
+    [[nodiscard]] Node get_parent(Node node) const noexcept;
+    [[nodiscard]] Node get_first_child(Node node) const noexcept;
+    [[nodiscard]] Node get_next_sibling(Node node) const noexcept;
+    [[nodiscard]] llvm::iterator_range<ChildIterator> children(Node node) const noexcept;
+
+    // Token table accessors
+    [[nodiscard]] size_t get_token_count() const noexcept {
+        return tokens_.size();
+    }
+    [[nodiscard]] lex::TokenKind get_token_kind(TokenIndex index) const noexcept;
+    [[nodiscard]] llvm::StringRef get_token_spelling(TokenIndex index) const noexcept;
+    [[nodiscard]] source::SourceLocation get_token_location(TokenIndex index) const noexcept;
+
+private:
+    using Word = llvm::support::ulittle32_t;
+
+    struct Header {
+        char magic[4];
+        Word version;
+        Word node_kind_count;
+        Word token_kind_count;
+        Word node_count;
+        Word token_count;
+        Word filename_size;
+        Word strings_size;
+    };
+
+    struct TokenEntry {
+        Word kind;
+        Word spelling_offset;
+        Word spelling_size;
+        Word line;
+        Word column;
+        Word offset;
+    };
+
+    std::unique_ptr<llvm::MemoryBuffer> buffer_;
+    llvm::ArrayRef<uint8_t> kinds_;
+    llvm::ArrayRef<Word> token_indices_;
+    llvm::ArrayRef<Word> parents_;
+    llvm::ArrayRef<Word> first_children_;
+    llvm::ArrayRef<Word> next_siblings_;
+    llvm::ArrayRef<Word> errors_;
+    llvm::ArrayRef<TokenEntry> tokens_;
+    llvm::StringRef strings_;
+    llvm::StringRef filename_;
+
+    explicit SerializedAST(std::unique_ptr<llvm::MemoryBuffer> buffer)
+        : buffer_(std::move(buffer)) {}
+
+    [[nodiscard]] bool is_valid_node(Node node) const noexcept {
+        return node.is_valid() && node.get_index() < size();
+    }
+    [[nodiscard]] Node get_link(llvm::ArrayRef<Word> links, Node node) const noexcept;
+};
+
+// Child iterator following next-sibling links
+class SerializedAST::ChildIterator : public llvm::iterator_facade_base<ChildIterator,
+                                                                       std::forward_iterator_tag,
+                                                                       Node,
+                                                                       ptrdiff_t,
+                                                                       const Node*,
+                                                                       const Node> {
+public:
+    ChildIterator() noexcept = default;
+
+    bool operator==(const ChildIterator& rhs) const noexcept {
+        return child_ == rhs.child_ && ast_ == rhs.ast_;
+    }
+
+    Node operator*() const noexcept {
+        return child_;
+    }
+    ChildIterator& operator++() noexcept {
+        child_ = ast_ ? ast_->get_next_sibling(child_) : Node();
+        return *this;
+    }
+
+private:
+    friend class SerializedAST;
+
+    ChildIterator(const SerializedAST* ast, Node child) noexcept : ast_(ast), child_(child) {}
+
+    const SerializedAST* ast_{nullptr};
+    Node child_;
+};
+
+}  // namespace ziv::toolchain::ast
+
+#endif  // ZIV_TOOLCHAIN_AST_SERIALIZATION_HPP
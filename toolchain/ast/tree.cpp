@@ -5,44 +5,350 @@
 #include "toolchain/ast/tree.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <numeric>
+#include <thread>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/xxhash.h"
 
 namespace ziv::toolchain::ast {
 
 AST::Node AST::get_root() const noexcept {
-    return empty() ? Node() : Node(1, this);
+    return empty() ? Node() : Node(1);
+}
+
+AST::Node AST::get_node(size_t index) const noexcept {
+    return index < kinds_.size() ? Node(static_cast<uint32_t>(index)) : Node();
+}
+
+const AST::Token& AST::get_token(Node node) const noexcept {
+    static const Token empty = Token::create_empty();
+    if (!is_valid_node(node)) {
+        return empty;
+    }
+    const TokenIndex token_index = token_indices_[node.get_index()];
+    return token_index < tokens_.size() ? tokens_[token_index] : empty;
 }
 
-ziv::toolchain::lex::TokenBuffer::Token AST::get_token(Node node) const noexcept {
-    return is_valid_node(node) ? nodes_[node.index_].token
-                               : toolchain::lex::TokenBuffer::Token::create_empty();
+AST::TokenIndex AST::get_token_index(Node node) const noexcept {
+    return is_valid_node(node) ? token_indices_[node.get_index()] : NO_TOKEN;
 }
+
 bool AST::is_valid_node(Node node) const noexcept {
-    return node.index_ > 0 && node.index_ < nodes_.size()
-           && nodes_[node.index_].kind != NodeKind::Invalid();
+    return node.is_valid() && node.get_index() < kinds_.size()
+           && kinds_[node.get_index()] != NodeKind::Invalid();
 }
 
 NodeKind AST::get_kind(Node node) const noexcept {
-    return is_valid_node(node) ? nodes_[node.index_].kind : NodeKind::Invalid();
+    return is_valid_node(node) ? kinds_[node.get_index()] : NodeKind::Invalid();
 }
 
 llvm::StringRef AST::get_spelling(Node node) const noexcept {
-    return is_valid_node(node) ? nodes_[node.index_].token.get_spelling() : llvm::StringRef();
+    return get_token(node).get_spelling();
 }
 
 size_t AST::get_line(Node node) const noexcept {
-    return is_valid_node(node) ? nodes_[node.index_].token.get_line() : 0;
+    return get_token(node).get_line();
+}
+
+source::SourceLocation AST::get_location(Node node) const noexcept {
+    const auto& token = get_token(node);
+    return {token.filename, token.get_line(), token.get_column(), 0, token.get_spelling().size()};
 }
 
 bool AST::has_error(Node node) const noexcept {
-    return is_valid_node(node) && nodes_[node.index_].has_error;
+    return is_valid_node(node) && errors_[static_cast<unsigned>(node.get_index())];
+}
+
+AST::Node AST::get_parent(Node node) const noexcept {
+    return is_valid_node(node) ? Node(parents_[node.get_index()]) : Node();
+}
+
+AST::Node AST::get_first_child(Node node) const noexcept {
+    return is_valid_node(node) ? Node(first_children_[node.get_index()]) : Node();
+}
+
+AST::Node AST::get_next_sibling(Node node) const noexcept {
+    return is_valid_node(node) ? Node(next_siblings_[node.get_index()]) : Node();
 }
 
 // Tree Modification Methods
-AST::Node AST::add_node(NodeKind kind, ziv::toolchain::lex::TokenBuffer::Token token) {
-    size_t index = nodes_.size();
-    nodes_.emplace_back(NodeData(kind, token));
-    return Node(index, this);
+AST::Node AST::add_node(NodeKind kind, TokenIndex token_index) {
+    return Node(append_node(kind, token_index));
+}
+
+size_t AST::append(AST&& fragment) {
+    assert(fragment.tokens_.data() == tokens_.data() && "fragments share the token buffer");
+
+    // Index 0 of both trees is the invalid sentinel, so fragment index i
+    // becomes i + offset
+    const auto offset = static_cast<uint32_t>(kinds_.size() - 1);
+    auto shift = [offset](uint32_t link) {
+        return link != 0 ? link + offset : 0;
+    };
+
+    for (size_t index = 1; index < fragment.kinds_.size(); ++index) {
+        const uint32_t appended = append_node(fragment.kinds_[index],
+                                              fragment.token_indices_[index]);
+        parents_[appended] = shift(fragment.parents_[index]);
+        first_children_[appended] = shift(fragment.first_children_[index]);
+        last_children_[appended] = shift(fragment.last_children_[index]);
+        next_siblings_[appended] = shift(fragment.next_siblings_[index]);
+        errors_[appended] = fragment.errors_[static_cast<unsigned>(index)];
+    }
+    for (const auto& [placeholder, token_index] : fragment.deferred_bodies_) {
+        deferred_bodies_[placeholder + offset] = token_index;
+    }
+    for (const auto& span : fragment.declaration_spans_) {
+        declaration_spans_.push_back({span.begin, span.end, span.node ? span.node + offset : 0});
+    }
+
+    fragment = AST();
+    fragment.tokens_ = tokens_;
+    return offset;
+}
+
+void AST::replace(Node node, Node replacement) {
+    if (!is_valid_node(node) || !is_valid_node(replacement) || node == replacement) {
+        return;
+    }
+
+    const uint32_t index = static_cast<uint32_t>(node.get_index());
+    const uint32_t replacement_index = static_cast<uint32_t>(replacement.get_index());
+    const uint32_t parent = parents_[index];
+    if (parent == 0 || is_ancestor(replacement, Node(parent))) {
+        return;
+    }
+    clear_derived();
+
+    if (parents_[replacement_index] != 0) {
+        unlink_child(parents_[replacement_index], replacement_index);
+    }
+
+    // Splice `replacement` into the sibling list where `node` was
+    uint32_t* link = &first_children_[parent];
+    while (*link != index) {
+        link = &next_siblings_[*link];
+    }
+    *link = replacement_index;
+    next_siblings_[replacement_index] = next_siblings_[index];
+    if (last_children_[parent] == index) {
+        last_children_[parent] = replacement_index;
+    }
+    parents_[replacement_index] = parent;
+    parents_[index] = 0;
+    next_siblings_[index] = 0;
+    deferred_bodies_.erase(index);
+
+    if (errors_[replacement_index]) {
+        propagate_error(parent);
+    }
+}
+
+void AST::defer_body(Node placeholder, size_t token_index) {
+    if (is_valid_node(placeholder)) {
+        deferred_bodies_[placeholder.get_index()] = token_index;
+    }
+}
+
+std::optional<size_t> AST::get_deferred_body(Node placeholder) const {
+    auto it = deferred_bodies_.find(placeholder.get_index());
+    if (it == deferred_bodies_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void AST::add_declaration_span(size_t begin, size_t end, Node node) {
+    declaration_spans_.push_back({begin, end, is_valid_node(node) ? node.get_index() : 0});
+}
+
+llvm::SmallVector<AST::Node, 0> AST::compact() {
+    llvm::SmallVector<Node, 0> remap(kinds_.size(), Node());
+    if (empty()) {
+        return remap;
+    }
+
+    // Live nodes in their new order; index 0 stays the invalid sentinel
+    llvm::SmallVector<uint32_t, 0> live{0};
+    for (Node node : preorder(get_root())) {
+        remap[node.get_index()] = Node(static_cast<uint32_t>(live.size()));
+        live.push_back(static_cast<uint32_t>(node.get_index()));
+    }
+    auto map = [&remap](uint32_t index) {
+        return static_cast<uint32_t>(remap[index].get_index());
+    };
+
+    AST compacted;
+    compacted.tokens_ = tokens_;
+    compacted.kinds_.reserve(live.size());
+    compacted.token_indices_.reserve(live.size());
+    compacted.parents_.reserve(live.size());
+    compacted.first_children_.reserve(live.size());
+    compacted.last_children_.reserve(live.size());
+    compacted.next_siblings_.reserve(live.size());
+    compacted.errors_.reserve(static_cast<unsigned>(live.size()));
+    for (size_t position = 1; position < live.size(); ++position) {
+        const uint32_t old_index = live[position];
+        const uint32_t index = compacted.append_node(kinds_[old_index], token_indices_[old_index]);
+        compacted.parents_[index] = map(parents_[old_index]);
+        compacted.first_children_[index] = map(first_children_[old_index]);
+        compacted.last_children_[index] = map(last_children_[old_index]);
+        compacted.next_siblings_[index] = map(next_siblings_[old_index]);
+        compacted.errors_[index] = errors_[old_index];
+    }
+
+    for (const auto& [placeholder, token_index] : deferred_bodies_) {
+        if (remap[placeholder].is_valid()) {
+            compacted.deferred_bodies_[remap[placeholder].get_index()] = token_index;
+        }
+    }
+    for (const auto& span : declaration_spans_) {
+        compacted.declaration_spans_.push_back(
+            {span.begin, span.end, span.node ? remap[span.node].get_index() : 0});
+    }
+    if (!subtree_hashes_.empty()) {
+        compacted.subtree_hashes_.resize(live.size());
+        for (size_t position = 1; position < live.size(); ++position) {
+            compacted.subtree_hashes_[position] = subtree_hashes_[live[position]];
+        }
+    }
+    if (has_postorder_layout()) {
+        compacted.layout_postorder();
+    }
+    if (has_kind_index()) {
+        compacted.build_kind_index();
+    }
+
+    *this = std::move(compacted);
+    return remap;
+}
+
+void AST::splice_declarations(size_t first,
+                              size_t last,
+                              AST&& fragment,
+                              ptrdiff_t token_shift) {
+    assert(first <= last && last <= declaration_spans_.size() && "replaced spans exist");
+    if (empty()) {
+        return;
+    }
+    if (!has_postorder_layout()) {
+        layout_postorder();
+    }
+
+    auto shift = [token_shift](size_t token_index) {
+        return static_cast<size_t>(static_cast<ptrdiff_t>(token_index) + token_shift);
+    };
+    const uint32_t root = 1;
+
+    // The replaced declarations are consecutive children of the root, after
+    // `previous`, and their subtrees consecutive in the layout from `begin` on
+    uint32_t previous = 0;
+    for (size_t span = first; span > 0 && previous == 0; --span) {
+        previous = static_cast<uint32_t>(declaration_spans_[span - 1].node);
+    }
+    const uint32_t begin = previous != 0 ? postorder_positions_[previous] + 1 : 0;
+    uint32_t next = previous != 0 ? next_siblings_[previous] : first_children_[root];
+    uint32_t end = begin;
+    for (size_t span = first; span < last; ++span) {
+        const auto node = static_cast<uint32_t>(declaration_spans_[span].node);
+        if (node == 0) {
+            continue;
+        }
+        assert(node == next && "declarations are the children of the root");
+        end += subtree_sizes_[node];
+        next = next_siblings_[node];
+        parents_[node] = 0;
+        next_siblings_[node] = 0;
+    }
+    for (uint32_t position = begin; position < end; ++position) {
+        const auto index = static_cast<uint32_t>(postorder_[position].get_index());
+        subtree_sizes_[index] = 0;
+        deferred_bodies_.erase(index);
+    }
+
+    // Fragment nodes go to the end of the arena and their spans in place of
+    // the replaced ones
+    const size_t fragment_spans = fragment.declaration_spans_.size();
+    append(std::move(fragment));
+    llvm::SmallVector<DeclarationSpan, 16> spans(declaration_spans_.end() - fragment_spans,
+                                                 declaration_spans_.end());
+    declaration_spans_.truncate(declaration_spans_.size() - fragment_spans);
+    for (size_t span = last; span < declaration_spans_.size(); ++span) {
+        declaration_spans_[span].begin = shift(declaration_spans_[span].begin);
+        declaration_spans_[span].end = shift(declaration_spans_[span].end);
+    }
+    declaration_spans_.erase(declaration_spans_.begin() + first, declaration_spans_.begin() + last);
+    declaration_spans_.insert(declaration_spans_.begin() + first, spans.begin(), spans.end());
+
+    // Link the fragment declarations where the replaced ones were and lay
+    // them out
+    postorder_positions_.resize(kinds_.size(), 0);
+    subtree_sizes_.resize(kinds_.size(), 0);
+    llvm::SmallVector<Node, 0> order;
+    uint32_t* link = previous != 0 ? &next_siblings_[previous] : &first_children_[root];
+    uint32_t linked = previous;
+    for (const auto& span : spans) {
+        if (span.node == 0) {
+            continue;
+        }
+        linked = static_cast<uint32_t>(span.node);
+        *link = linked;
+        parents_[linked] = root;
+        link = &next_siblings_[linked];
+        layout_subtree(linked, begin + static_cast<uint32_t>(order.size()), order);
+    }
+    *link = next;
+    if (next == 0) {
+        last_children_[root] = linked;
+    }
+
+    // Splice the fragment into the layout. Positions after it move with the
+    // size difference, and tokens after the edit with `token_shift`.
+    const uint32_t fragment_end = begin + static_cast<uint32_t>(order.size());
+    if (order.size() > end - begin) {
+        postorder_.insert(postorder_.begin() + end, order.size() - (end - begin), Node());
+    } else {
+        postorder_.erase(postorder_.begin() + fragment_end, postorder_.begin() + end);
+    }
+    llvm::copy(order, postorder_.begin() + begin);
+    subtree_sizes_[root] = static_cast<uint32_t>(postorder_.size());
+    if (fragment_end != end || token_shift != 0) {
+        for (uint32_t position = fragment_end; position + 1 < postorder_.size(); ++position) {
+            const auto index = static_cast<uint32_t>(postorder_[position].get_index());
+            postorder_positions_[index] = position;
+            if (token_indices_[index] != NO_TOKEN) {
+                token_indices_[index] = static_cast<TokenIndex>(shift(token_indices_[index]));
+            }
+            if (kinds_[index] == NodeKind::Placeholder()) {
+                if (auto deferred = deferred_bodies_.find(index);
+                    deferred != deferred_bodies_.end()) {
+                    deferred->second = shift(deferred->second);
+                }
+            }
+        }
+        postorder_positions_[root] = static_cast<uint32_t>(postorder_.size() - 1);
+    }
+
+    // The root's error flag and hash summarize its children, which changed
+    errors_.reset(root);
+    for (uint32_t child = first_children_[root]; child != 0; child = next_siblings_[child]) {
+        if (errors_[child]) {
+            errors_.set(root);
+            break;
+        }
+    }
+    if (has_subtree_hashes()) {
+        subtree_hashes_.resize(kinds_.size(), 0);
+        llvm::SmallString<64> bytes;
+        for (Node node : order) {
+            hash_node(static_cast<uint32_t>(node.get_index()), bytes);
+        }
+        hash_node(root, bytes);
+    }
 }
 
 void AST::add_child(Node parent, Node child) {
@@ -50,24 +356,44 @@ void AST::add_child(Node parent, Node child) {
         return;
     }
 
-    // Prevent cycles
+    const auto parent_index = static_cast<uint32_t>(parent.get_index());
+    const auto child_index = static_cast<uint32_t>(child.get_index());
+
+    // Prevent cycles. This runs on the layout when there is one, which a
+    // rejected edge leaves in place.
     if (is_ancestor(child, parent)) {
         mark_error(parent);
         return;
     }
+    clear_derived();
 
     // Remove from old parent if exists
-    if (nodes_[child.index_].parent != 0) {
-        unlink_child(nodes_[child.index_].parent, child.index_);
+    if (parents_[child_index] != 0) {
+        unlink_child(parents_[child_index], child_index);
     }
 
-    // Add to new parent
-    nodes_[parent.index_].children.push_back(child.index_);
-    nodes_[child.index_].parent = parent.index_;
+    link_child(parent_index, child_index);
 
     // Propagate errors if needed
-    if (nodes_[child.index_].has_error) {
-        propagate_error(parent.index_);
+    if (errors_[child_index]) {
+        propagate_error(parent_index);
+    }
+}
+
+void AST::append_child(Node parent, Node child) {
+    if (!is_valid_node(parent) || !is_valid_node(child)) {
+        return;
+    }
+
+    const auto parent_index = static_cast<uint32_t>(parent.get_index());
+    const auto child_index = static_cast<uint32_t>(child.get_index());
+    assert(parents_[child_index] == 0 && "appended child already has a parent");
+    assert(!is_ancestor(child, parent) && "appended child is an ancestor of its parent");
+    clear_derived();
+
+    link_child(parent_index, child_index);
+    if (errors_[child_index]) {
+        propagate_error(parent_index);
     }
 }
 
@@ -76,33 +402,300 @@ void AST::mark_error(Node node) {
         return;
     }
 
-    if (!nodes_[node.index_].has_error) {
-        propagate_error(node.index_);
+    if (!errors_[static_cast<unsigned>(node.get_index())]) {
+        propagate_error(static_cast<uint32_t>(node.get_index()));
     }
 }
 
 void AST::clear_error(Node node) noexcept {
     if (is_valid_node(node)) {
-        nodes_[node.index_].has_error = false;
+        errors_.reset(static_cast<unsigned>(node.get_index()));
+    }
+}
+
+// Postorder Layout
+std::optional<AST::SubtreeInterval> AST::get_subtree_interval(Node node) const noexcept {
+    const size_t size = get_subtree_size(node);
+    if (size == 0) {
+        return std::nullopt;
+    }
+    const uint32_t exit = postorder_positions_[node.get_index()];
+    return SubtreeInterval{exit + 1 - static_cast<uint32_t>(size), exit};
+}
+
+size_t AST::get_subtree_size(Node node) const noexcept {
+    return node.get_index() < subtree_sizes_.size() ? subtree_sizes_[node.get_index()] : 0;
+}
+
+llvm::ArrayRef<AST::Node> AST::postorder_subtree(Node node) const noexcept {
+    const size_t size = get_subtree_size(node);
+    if (size == 0) {
+        return {};
+    }
+    const size_t position = postorder_positions_[node.get_index()];
+    return llvm::ArrayRef<Node>(postorder_).slice(position + 1 - size, size);
+}
+
+// Structural Hashing
+void AST::compute_subtree_hashes() {
+    subtree_hashes_.assign(kinds_.size(), 0);
+
+    // Children are hashed before their parent in postorder
+    llvm::SmallString<64> bytes;
+    if (!postorder_.empty()) {
+        for (Node node : postorder_) {
+            hash_node(static_cast<uint32_t>(node.get_index()), bytes);
+        }
+    } else {
+        for (Node node : nodes()) {
+            hash_node(static_cast<uint32_t>(node.get_index()), bytes);
+        }
+    }
+}
+
+uint64_t AST::get_subtree_hash(Node node) const noexcept {
+    return node.get_index() < subtree_hashes_.size() ? subtree_hashes_[node.get_index()] : 0;
+}
+
+bool AST::is_same_subtree(Node node, const AST& other, Node other_node) const {
+    const uint64_t hash = get_subtree_hash(node);
+    const uint64_t other_hash = other.get_subtree_hash(other_node);
+    if (hash != 0 && other_hash != 0 && hash != other_hash) {
+        return false;
+    }
+
+    llvm::SmallVector<std::pair<Node, Node>, 32> pending{{node, other_node}};
+    while (!pending.empty()) {
+        const auto [lhs, rhs] = pending.pop_back_val();
+        if (get_kind(lhs) != other.get_kind(rhs) || get_spelling(lhs) != other.get_spelling(rhs)) {
+            return false;
+        }
+
+        Node lhs_child = get_first_child(lhs);
+        Node rhs_child = other.get_first_child(rhs);
+        while (lhs_child.is_valid() && rhs_child.is_valid()) {
+            pending.push_back({lhs_child, rhs_child});
+            lhs_child = get_next_sibling(lhs_child);
+            rhs_child = other.get_next_sibling(rhs_child);
+        }
+        if (lhs_child.is_valid() || rhs_child.is_valid()) {
+            return false;  // Different number of children
+        }
+    }
+    return true;
+}
+
+// Kind Index
+void AST::build_kind_index() {
+    // Counting sort: count the nodes of each kind, turn the counts into
+    // group offsets, then place the nodes in id order
+    kind_offsets_.assign(NodeKind::KIND_COUNT + 1, 0);
+    for (size_t index = 1; index < kinds_.size(); ++index) {
+        ++kind_offsets_[kinds_[index].to_int() + 1u];
+    }
+    for (size_t kind = 0; kind < NodeKind::KIND_COUNT; ++kind) {
+        kind_offsets_[kind + 1] += kind_offsets_[kind];
+    }
+
+    llvm::SmallVector<uint32_t, 0> next(kind_offsets_.begin(), kind_offsets_.end() - 1);
+    kind_nodes_.assign(kinds_.size() - 1, Node());
+    for (size_t index = 1; index < kinds_.size(); ++index) {
+        kind_nodes_[next[kinds_[index].to_int()]++] = Node(static_cast<uint32_t>(index));
+    }
+}
+
+llvm::ArrayRef<AST::Node> AST::get_nodes_of_kind(NodeKind kind) const noexcept {
+    if (!has_kind_index()) {
+        return {};
+    }
+    const uint32_t begin = kind_offsets_[kind.to_int()];
+    const uint32_t end = kind_offsets_[kind.to_int() + 1u];
+    return llvm::ArrayRef<Node>(kind_nodes_).slice(begin, end - begin);
+}
+
+// Parallel Subtree Traversal
+llvm::SmallVector<AST::Node, 0>
+AST::collect_subtrees(llvm::function_ref<bool(Node)> predicate) const {
+    llvm::SmallVector<Node, 0> roots;
+    auto walk = preorder(get_root());
+    for (auto it = walk.begin(); it != walk.end();) {
+        if (predicate(*it)) {
+            roots.push_back(*it);
+            it.skip_subtree();
+        } else {
+            ++it;
+        }
+    }
+    return roots;
+}
+
+llvm::SmallVector<size_t, 0> AST::schedule_subtrees(llvm::ArrayRef<Node> roots) const {
+    // Sizes come from the postorder layout when there is one
+    llvm::SmallVector<size_t, 0> sizes;
+    sizes.reserve(roots.size());
+    for (Node root : roots) {
+        size_t size = get_subtree_size(root);
+        if (size == 0) {
+            auto nodes = subtree(root);
+            size = static_cast<size_t>(std::distance(nodes.begin(), nodes.end()));
+        }
+        sizes.push_back(size);
+    }
+
+    llvm::SmallVector<size_t, 0> order(roots.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+        return sizes[lhs] > sizes[rhs];
+    });
+    return order;
+}
+
+void AST::run_parallel(size_t count, size_t jobs, llvm::function_ref<void(size_t)> task) {
+    if (jobs == 0) {
+        jobs = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    jobs = std::min(jobs, count);
+
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t index = next++; index < count; index = next++) {
+            task(index);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(jobs > 0 ? jobs - 1 : 0);
+    for (size_t worker = 1; worker < jobs; ++worker) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
     }
 }
 
 // Internal Helper Methods
-void AST::propagate_error(size_t index) noexcept {
-    size_t current = index;
+uint32_t AST::append_node(NodeKind kind, TokenIndex token_index) {
+    assert(kinds_.size() < UINT32_MAX && "node ids are 32 bits");
+    const auto index = static_cast<uint32_t>(kinds_.size());
+    if (has_kind_index()) {
+        kind_offsets_.clear();
+        kind_nodes_.clear();
+    }
+    kinds_.push_back(kind);
+    token_indices_.push_back(token_index);
+    parents_.push_back(0);
+    first_children_.push_back(0);
+    last_children_.push_back(0);
+    next_siblings_.push_back(0);
+    errors_.push_back(false);
+    return index;
+}
+
+void AST::link_child(uint32_t parent, uint32_t child) noexcept {
+    if (last_children_[parent] != 0) {
+        next_siblings_[last_children_[parent]] = child;
+    } else {
+        first_children_[parent] = child;
+    }
+    last_children_[parent] = child;
+    parents_[child] = parent;
+}
+
+void AST::layout_postorder() {
+    clear_postorder();
+    if (empty()) {
+        return;
+    }
+
+    postorder_positions_.assign(kinds_.size(), 0);
+    subtree_sizes_.assign(kinds_.size(), 0);
+    layout_subtree(1, 0, postorder_);
+}
+
+void AST::layout_subtree(uint32_t index, uint32_t base, llvm::SmallVectorImpl<Node>& order) {
+    // (node, next child to visit); a node is emitted once all of its children
+    // have been
+    llvm::SmallVector<std::pair<uint32_t, uint32_t>, 32> pending{{index, first_children_[index]}};
+    while (!pending.empty()) {
+        auto& [node, next_child] = pending.back();
+        if (next_child != 0) {
+            const uint32_t child = next_child;
+            next_child = next_siblings_[child];
+            pending.push_back({child, first_children_[child]});
+            continue;
+        }
+
+        uint32_t size = 1;
+        for (uint32_t child = first_children_[node]; child != 0; child = next_siblings_[child]) {
+            size += subtree_sizes_[child];
+            if (errors_[child]) {
+                errors_.set(node);
+            }
+        }
+        subtree_sizes_[node] = size;
+        postorder_positions_[node] = base + static_cast<uint32_t>(order.size());
+        order.push_back(Node(node));
+        pending.pop_back();
+    }
+}
+
+void AST::hash_node(uint32_t index, llvm::SmallVectorImpl<char>& bytes) {
+    const llvm::StringRef spelling = get_spelling(Node(index));
+    const auto spelling_size = static_cast<uint32_t>(spelling.size());
+    bytes.clear();
+    bytes.push_back(static_cast<char>(kinds_[index].to_int()));
+    bytes.append(reinterpret_cast<const char*>(&spelling_size),
+                 reinterpret_cast<const char*>(&spelling_size + 1));
+    bytes.append(spelling.begin(), spelling.end());
+    for (uint32_t child = first_children_[index]; child != 0; child = next_siblings_[child]) {
+        const uint64_t& hash = subtree_hashes_[child];
+        bytes.append(reinterpret_cast<const char*>(&hash),
+                     reinterpret_cast<const char*>(&hash + 1));
+    }
+    subtree_hashes_[index] = llvm::xxHash64(llvm::StringRef(bytes.data(), bytes.size()));
+}
+
+void AST::clear_postorder() noexcept {
+    postorder_.clear();
+    postorder_positions_.clear();
+    subtree_sizes_.clear();
+}
+
+void AST::clear_derived() noexcept {
+    clear_postorder();
+    subtree_hashes_.clear();
+}
+
+void AST::propagate_error(uint32_t index) noexcept {
+    uint32_t current = index;
     while (current != 0) {
-        auto& node = nodes_[current];
-        if (node.has_error)
+        if (errors_[current])
             break;
-        node.has_error = true;
-        current = node.parent;
+        errors_.set(current);
+        current = parents_[current];
     }
 }
 
-void AST::unlink_child(size_t parent_idx, size_t child_idx) noexcept {
-    auto& parent_children = nodes_[parent_idx].children;
-    parent_children.erase(std::remove(parent_children.begin(), parent_children.end(), child_idx),
-                          parent_children.end());
+void AST::unlink_child(uint32_t parent, uint32_t child) noexcept {
+    uint32_t previous = 0;
+    for (uint32_t sibling = first_children_[parent]; sibling != 0;
+         previous = sibling, sibling = next_siblings_[sibling]) {
+        if (sibling != child) {
+            continue;
+        }
+        if (previous != 0) {
+            next_siblings_[previous] = next_siblings_[child];
+        } else {
+            first_children_[parent] = next_siblings_[child];
+        }
+        if (last_children_[parent] == child) {
+            last_children_[parent] = previous;
+        }
+        break;
+    }
+    next_siblings_[child] = 0;
+    parents_[child] = 0;
 }
 
 bool AST::is_ancestor(Node ancestor, Node descendant) const noexcept {
@@ -110,113 +703,140 @@ bool AST::is_ancestor(Node ancestor, Node descendant) const noexcept {
         return false;
     }
 
-    size_t current = descendant.index_;
+    // Nodes outside the layout are not reachable from the root, so they can
+    // only be related to each other
+    const auto interval = get_subtree_interval(ancestor);
+    const auto descendant_interval = get_subtree_interval(descendant);
+    if (interval || descendant_interval) {
+        return interval && descendant_interval && interval->entry <= descendant_interval->exit
+               && descendant_interval->exit <= interval->exit;
+    }
+
+    uint32_t current = static_cast<uint32_t>(descendant.get_index());
     while (current != 0) {
-        if (current == ancestor.index_) {
+        if (current == ancestor.get_index()) {
             return true;
         }
-        current = nodes_[current].parent;
+        current = parents_[current];
     }
     return false;
 }
 
 // Traversal Methods
 llvm::iterator_range<AST::TreeIterator> AST::nodes() const noexcept {
-    return empty() ? llvm::make_range(TreeIterator(), TreeIterator())
-                   : llvm::make_range(TreeIterator(this, get_root()),
-                                      TreeIterator(this, Node::create_end_node(this)));
+    return subtree(get_root());
 }
 
 llvm::iterator_range<AST::TreeIterator> AST::subtree(Node node) const noexcept {
-    return !is_valid_node(node) ? llvm::make_range(TreeIterator(), TreeIterator())
-                                : llvm::make_range(TreeIterator(this, node),
-                                                   TreeIterator(this, Node::create_end_node(this)));
-}
-
-llvm::iterator_range<AST::ChildIterator> AST::children(Node node) const noexcept {
-    return !is_valid_node(node)
-               ? llvm::make_range(ChildIterator(), ChildIterator())
-               : llvm::make_range(ChildIterator(this, node, 0),
-                                  ChildIterator(this, node, nodes_[node.index_].children.size()));
-}
-
-// Node Implementation
-bool AST::Node::is_valid() const noexcept {
-    return ast_ && ast_->is_valid_node(*this);
-}
+    if (!is_valid_node(node)) {
+        return llvm::make_range(TreeIterator(), TreeIterator());
+    }
 
-bool AST::Node::has_error() const noexcept {
-    return ast_ && ast_->has_error(*this);
+    Node first = node;
+    while (first_children_[first.get_index()] != 0) {
+        first = Node(first_children_[first.get_index()]);
+    }
+    return llvm::make_range(TreeIterator(this, first, node), TreeIterator(this, Node(), node));
 }
 
-NodeKind AST::Node::get_kind() const noexcept {
-    return ast_ ? ast_->get_kind(*this) : NodeKind::Invalid();
+llvm::iterator_range<AST::PreorderIterator> AST::preorder(Node node) const noexcept {
+    return !is_valid_node(node) ? llvm::make_range(PreorderIterator(), PreorderIterator())
+                                : llvm::make_range(PreorderIterator(this, node, node),
+                                                   PreorderIterator(this, Node(), node));
 }
 
-llvm::StringRef AST::Node::get_spelling() const noexcept {
-    return ast_ ? ast_->get_spelling(*this) : llvm::StringRef();
+llvm::iterator_range<AST::LevelOrderIterator> AST::level_order(Node node) const noexcept {
+    return !is_valid_node(node) ? llvm::make_range(LevelOrderIterator(), LevelOrderIterator())
+                                : llvm::make_range(LevelOrderIterator(this, node),
+                                                   LevelOrderIterator(this, Node()));
 }
 
-size_t AST::Node::get_line() const noexcept {
-    return ast_ ? ast_->get_line(*this) : 0;
+llvm::iterator_range<AST::ChildIterator> AST::children(Node node) const noexcept {
+    return !is_valid_node(node) ? llvm::make_range(ChildIterator(), ChildIterator())
+                                : llvm::make_range(ChildIterator(this, get_first_child(node)),
+                                                   ChildIterator(this, Node()));
 }
 
 // TreeIterator Implementation
-AST::TreeIterator& AST::TreeIterator::operator++() {
+AST::TreeIterator& AST::TreeIterator::operator++() noexcept {
     if (!ast_ || !node_.is_valid()) {
         return *this;
     }
 
-    node_ = find_next_postorder(node_);
+    const uint32_t index = static_cast<uint32_t>(node_.get_index());
+    if (node_ == root_) {
+        node_ = Node();
+        return *this;
+    }
+
+    // The next sibling's leftmost leaf comes next, or the parent once all of
+    // its children are done
+    if (uint32_t next = ast_->next_siblings_[index]; next != 0) {
+        while (ast_->first_children_[next] != 0) {
+            next = ast_->first_children_[next];
+        }
+        node_ = Node(next);
+    } else {
+        node_ = Node(ast_->parents_[index]);
+    }
     return *this;
 }
 
-AST::Node AST::TreeIterator::find_leftmost_leaf(Node start) const noexcept {
-    if (!start.is_valid())
-        return Node();
+// PreorderIterator Implementation
+AST::PreorderIterator& AST::PreorderIterator::operator++() noexcept {
+    if (!ast_ || !node_.is_valid()) {
+        return *this;
+    }
 
-    Node current = start;
-    while (!ast_->nodes_[current.index_].children.empty()) {
-        current = Node(ast_->nodes_[current.index_].children[0], ast_);
+    if (const uint32_t child = ast_->first_children_[node_.get_index()]; child != 0) {
+        node_ = Node(child);
+        return *this;
     }
-    return current;
+    return skip_subtree();
 }
 
-//... previous code remains the same until TreeIterator::find_next_postorder ...
-
-AST::Node AST::TreeIterator::find_next_postorder(Node current) const noexcept {
-    if (!current.is_valid())
-        return Node();
-
-    // If at root, we're done
-    if (current.index_ == 1) {
-        return Node(ast_->nodes_.size(), ast_);  // End iterator
+AST::PreorderIterator& AST::PreorderIterator::skip_subtree() noexcept {
+    if (!ast_ || !node_.is_valid()) {
+        return *this;
     }
 
-    const auto& parent = ast_->nodes_[ast_->nodes_[current.index_].parent];
-    auto it = std::find(parent.children.begin(), parent.children.end(), current.index_);
+    // Climb to the closest ancestor, up to the root, with a next sibling
+    uint32_t index = static_cast<uint32_t>(node_.get_index());
+    while (index != root_.get_index() && ast_->next_siblings_[index] == 0) {
+        index = ast_->parents_[index];
+    }
+    node_ = index == root_.get_index() ? Node() : Node(ast_->next_siblings_[index]);
+    return *this;
+}
 
-    // If we're not the last child, move to next sibling's leftmost descendant
-    if (it != parent.children.end() && std::next(it) != parent.children.end()) {
-        Node next_sibling(*(std::next(it)), ast_);
-        return find_leftmost_leaf(next_sibling);
+// LevelOrderIterator Implementation
+AST::LevelOrderIterator& AST::LevelOrderIterator::operator++() {
+    if (!ast_ || !node_.is_valid()) {
+        return *this;
     }
 
-    // Otherwise, move up to parent
-    return Node(ast_->nodes_[current.index_].parent, ast_);
-}
+    const uint32_t index = static_cast<uint32_t>(node_.get_index());
+    if (ast_->first_children_[index] != 0) {
+        parents_.push_back(node_);
+    }
 
-// ChildIterator Implementation
-AST::Node AST::ChildIterator::operator*() const noexcept {
-    if (!ast_ || !node_.is_valid() || index_ >= ast_->nodes_[node_.index_].children.size()) {
-        return Node();
+    // Siblings are visited in a row; after the last one, the children of the
+    // earliest queued node follow
+    if (node_ != root_ && ast_->next_siblings_[index] != 0) {
+        node_ = Node(ast_->next_siblings_[index]);
+    } else if (!parents_.empty()) {
+        node_ = Node(ast_->first_children_[parents_.front().get_index()]);
+        parents_.pop_front();
+    } else {
+        node_ = Node();
     }
-    return Node(ast_->nodes_[node_.index_].children[index_], ast_);
+    return *this;
 }
 
+// ChildIterator Implementation
 AST::ChildIterator& AST::ChildIterator::operator++() noexcept {
-    if (ast_ && node_.is_valid() && index_ < ast_->nodes_[node_.index_].children.size()) {
-        ++index_;
+    if (ast_ && child_.is_valid()) {
+        child_ = Node(ast_->next_siblings_[child_.get_index()]);
     }
     return *this;
 }
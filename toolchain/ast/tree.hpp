@@ -5,9 +5,20 @@
 #ifndef ZIV_TOOLCHAIN_AST_TREE_HPP
 #define ZIV_TOOLCHAIN_AST_TREE_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <optional>
 #include <stack>
-
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/iterator.h"
@@ -19,160 +30,377 @@
 
 namespace ziv::toolchain::ast {
 
+// Handle to a node: its index into the node arrays of the AST that created
+// it. Index 0 is the invalid node, so a default constructed id refers to
+// nothing. Properties are read through the AST.
+class NodeId {
+public:
+    constexpr NodeId() noexcept = default;
+    constexpr explicit NodeId(uint32_t index) noexcept : index_(index) {}
+
+    [[nodiscard]] constexpr bool is_valid() const noexcept {
+        return index_ != 0;
+    }
+    [[nodiscard]] constexpr size_t get_index() const noexcept {
+        return index_;
+    }
+
+    constexpr bool operator==(const NodeId& rhs) const noexcept {
+        return index_ == rhs.index_;
+    }
+    constexpr bool operator!=(const NodeId& rhs) const noexcept {
+        return index_ != rhs.index_;
+    }
+    constexpr bool operator<(const NodeId& rhs) const noexcept {
+        return index_ < rhs.index_;
+    }
+
+private:
+    uint32_t index_ = 0;
+};
+
+// Nodes are stored column-wise: one array per property, indexed by NodeId.
+// Children form a singly linked list through first-child and next-sibling
+// links, so adding a node never allocates per node and walks touch only the
+// arrays they read.
+//
+// Nodes refer to their token by index into the tokens set with set_tokens(),
+// normally those of the TokenBuffer the tree was parsed from, which must
+// outlive the tree.
 class AST {
 public:
-    class Node;
+    using Node = NodeId;
+    using Token = ziv::toolchain::lex::TokenBuffer::Token;
+    using TokenIndex = uint32_t;
     class TreeIterator;
+    class PreorderIterator;
+    class LevelOrderIterator;
     class ChildIterator;
 
-    struct NodeData {
-        NodeKind kind;
-        ziv::toolchain::lex::TokenBuffer::Token token;
-        llvm::SmallVector<size_t, 4> children;
-        size_t parent;
-        bool has_error : 1;
-        bool visited : 1;
-
-        NodeData()
-            : kind(NodeKind::Invalid()),
-              token(toolchain::lex::TokenBuffer::Token::create_empty()),
-              parent(0),
-              has_error(false),
-              visited(false) {}
-
-        NodeData(NodeKind kind, toolchain::lex::TokenBuffer::Token token)
-            : kind(kind), token(token), parent(0), has_error(false), visited(false) {}
+    // Token index of nodes without a token
+    static constexpr TokenIndex NO_TOKEN = UINT32_MAX;
+
+    // Tokens [begin, end) consumed by one top-level declaration. Spans are
+    // recorded in source order and cover every token after the file start;
+    // `node` is 0 when the tokens produced no declaration node.
+    struct DeclarationSpan {
+        size_t begin;
+        size_t end;
+        size_t node;
     };
 
     AST() {
-        nodes_.emplace_back(
-            NodeData(NodeKind::Invalid(), toolchain::lex::TokenBuffer::Token::create_empty()));
+        append_node(NodeKind::Invalid(), NO_TOKEN);
+    }
+
+    void set_tokens(llvm::ArrayRef<Token> tokens) noexcept {
+        tokens_ = tokens;
+    }
+    [[nodiscard]] llvm::ArrayRef<Token> get_tokens() const noexcept {
+        return tokens_;
     }
 
     // Core tree operations
     [[nodiscard]] size_t size() const noexcept {
-        return nodes_.size();
+        return kinds_.size();
     }
     [[nodiscard]] Node get_root() const noexcept;
+    [[nodiscard]] Node get_node(size_t index) const noexcept;
     [[nodiscard]] bool empty() const noexcept {
-        return nodes_.size() <= 1;
+        return kinds_.size() <= 1;
     }
 
     // Node property accessors
     [[nodiscard]] NodeKind get_kind(Node node) const noexcept;
-    [[nodiscard]] ziv::toolchain::lex::TokenBuffer::Token get_token(Node node) const noexcept;
+    // Nodes without a token, or whose token is outside get_tokens(), read as
+    // an empty Sof token.
+    [[nodiscard]] const Token& get_token(Node node) const noexcept;
+    [[nodiscard]] TokenIndex get_token_index(Node node) const noexcept;
     [[nodiscard]] llvm::StringRef get_spelling(Node node) const noexcept;
     [[nodiscard]] size_t get_line(Node node) const noexcept;
+    [[nodiscard]] source::SourceLocation get_location(Node node) const noexcept;
     [[nodiscard]] bool has_error(Node node) const noexcept;
 
+    // Structure accessors; each returns an invalid node where there is none
+    [[nodiscard]] Node get_parent(Node node) const noexcept;
+    [[nodiscard]] Node get_first_child(Node node) const noexcept;
+    [[nodiscard]] Node get_next_sibling(Node node) const noexcept;
+
     // Tree modification operations
-    Node add_node(NodeKind kind, ziv::toolchain::lex::TokenBuffer::Token token);
+    Node add_node(NodeKind kind, TokenIndex token_index = NO_TOKEN);
+    // Makes `child` the last child of `parent`, detaching it from any previous
+    // parent.
     void add_child(Node parent, Node child);
+    // Unchecked add_child() for producers that build trees without moving
+    // nodes, like the parser: `child` must not have a parent yet, which also
+    // rules out cycles. That is only asserted, so appending is O(1) instead
+    // of a walk to the root per call.
+    void append_child(Node parent, Node child);
     void mark_error(Node node);
     void clear_error(Node node) noexcept;
+    // Moves the nodes of `fragment`, which must refer to the same tokens, to
+    // the end of this tree and returns the offset added to their indices.
+    // Fragment roots are left unattached.
+    size_t append(AST&& fragment);
+    // Puts `replacement` in the place of `node` under its parent and detaches
+    // `node`.
+    void replace(Node node, Node replacement);
+
+    // Outline parsing leaves a Placeholder in place of each function body,
+    // recording the index of the body's Indent token until it is parsed.
+    void defer_body(Node placeholder, size_t token_index);
+    [[nodiscard]] std::optional<size_t> get_deferred_body(Node placeholder) const;
+
+    void add_declaration_span(size_t begin, size_t end, Node node);
+    [[nodiscard]] llvm::ArrayRef<DeclarationSpan> get_declaration_spans() const noexcept {
+        return declaration_spans_;
+    }
 
-    // Traversal interfaces
+    // Drops the nodes not reachable from the root, like error recovery
+    // nodes that were never attached and subtrees detached by later edits,
+    // and renumbers the rest densely in preorder with the root still first.
+    // Returns the new id of every old node index, invalid for dropped ones,
+    // so side tables keyed by node id can follow. Spans, deferred bodies,
+    // hashes, the layout and the kind index are carried over.
+    llvm::SmallVector<Node, 0> compact();
+
+    // Incremental reparsing: replaces the top-level declarations [first, last)
+    // of get_declaration_spans() with those of `fragment`, a parse of the
+    // edited tokens between them, and moves the declarations from `last` on,
+    // and the file end, `token_shift` tokens. The other nodes keep their ids.
+    // The postorder layout, laid out first if missing, and the hashes, if
+    // computed, are patched: only the fragment is laid out and hashed, and
+    // the positions after it shift. Replaced nodes stay in the arena,
+    // detached, until compact().
+    void splice_declarations(size_t first, size_t last, AST&& fragment, ptrdiff_t token_shift);
+
+    // Postorder layout: the nodes reachable from the root in postorder, with
+    // their subtree sizes. Each subtree then occupies one interval of
+    // postorder() that ends with its root, an Euler tour of the tree, so
+    // is_ancestor() compares positions and subtrees can be scanned or split
+    // as slices. Intervals only exist between a call to layout_postorder()
+    // and the next change to the links: add_child(), append_child() and
+    // replace() drop the layout rather than shift every position after the
+    // change, and callers relayout once they are done editing. The parser
+    // lays out the trees it builds.
+    struct SubtreeInterval {
+        uint32_t entry;  // Position of the first node of the subtree
+        uint32_t exit;   // Position of the subtree root
+    };
+    void layout_postorder();
+    [[nodiscard]] bool has_postorder_layout() const noexcept {
+        return !postorder_.empty();
+    }
+    [[nodiscard]] llvm::ArrayRef<Node> postorder() const noexcept {
+        return postorder_;
+    }
+    // Empty if `node` is not part of the postorder layout
+    [[nodiscard]] std::optional<SubtreeInterval> get_subtree_interval(Node node) const noexcept;
+    // Number of nodes in the subtree rooted at `node`, itself included, or
+    // zero if `node` is not part of the postorder layout.
+    [[nodiscard]] size_t get_subtree_size(Node node) const noexcept;
+    // The subtree rooted at `node` as a slice of postorder(), ending with
+    // `node` itself.
+    [[nodiscard]] llvm::ArrayRef<Node> postorder_subtree(Node node) const noexcept;
+
+    // Structural hashes. compute_subtree_hashes() hashes the nodes reachable
+    // from the root bottom-up, each over its kind, its spelling and the
+    // hashes of its children in order, so equal subtrees hash equally within
+    // and across trees and runs. Like the postorder layout, the hashes are
+    // dropped by later changes to the links.
+    void compute_subtree_hashes();
+    [[nodiscard]] bool has_subtree_hashes() const noexcept {
+        return !subtree_hashes_.empty();
+    }
+    // Zero if hashes are not computed or `node` was not reachable then
+    [[nodiscard]] uint64_t get_subtree_hash(Node node) const noexcept;
+    // True if the subtree of `node` and that of `other_node` in `other` have
+    // the same kinds, spellings and shape. Differing hashes answer without a
+    // walk; otherwise the subtrees are compared node by node.
+    [[nodiscard]] bool is_same_subtree(Node node, const AST& other, Node other_node) const;
+
+    // Traversal interfaces. nodes() and subtree() visit in postorder,
+    // children before their parent; preorder() visits parents first and
+    // level_order() breadth-first. Every step follows sibling and parent
+    // links, so a walk is linear in the size of the subtree.
     [[nodiscard]] llvm::iterator_range<TreeIterator> nodes() const noexcept;
     [[nodiscard]] llvm::iterator_range<TreeIterator> subtree(Node node) const noexcept;
+    [[nodiscard]] llvm::iterator_range<PreorderIterator> preorder(Node node) const noexcept;
+    [[nodiscard]] llvm::iterator_range<LevelOrderIterator> level_order(Node node) const noexcept;
     [[nodiscard]] llvm::iterator_range<ChildIterator> children(Node node) const noexcept;
 
+    // Kind index: the nodes of each kind in id order, stored as one array of
+    // ids grouped by kind plus the offset of each group, so a query costs
+    // O(matches). build_kind_index() indexes every node, including detached
+    // ones, in O(size()); adding nodes drops the index again.
+    void build_kind_index();
+    [[nodiscard]] bool has_kind_index() const noexcept {
+        return !kind_offsets_.empty();
+    }
+    // Empty if the index is not built
+    [[nodiscard]] llvm::ArrayRef<Node> get_nodes_of_kind(NodeKind kind) const noexcept;
+
+    // Calls `fn` concurrently on the largest subtrees whose roots satisfy
+    // `predicate`, found by a preorder walk from the root that does not look
+    // inside matches, and returns the results in source order. Subtrees are
+    // handed out largest first to `jobs` threads, zero meaning one per
+    // hardware thread, which pick up the next one as they finish, so a few
+    // big subtrees do not leave threads idle. `fn` must be safe to run
+    // concurrently and return a value; the tree must not change meanwhile.
+    template <typename Predicate, typename Function>
+    auto parallel_for_each_subtree(Predicate predicate, Function fn, size_t jobs = 0) const
+        -> llvm::SmallVector<std::invoke_result_t<Function&, Node>, 0>;
+
     // Validation helpers
     [[nodiscard]] bool is_valid_node(Node node) const noexcept;
+    // True if `descendant` is in the subtree of `ancestor`, itself included.
+    // Constant time on laid out trees, O(depth) otherwise.
     [[nodiscard]] bool is_ancestor(Node ancestor, Node descendant) const noexcept;
 
 private:
-    llvm::SmallVector<NodeData, 32> nodes_;  // Pre-allocated for typical AST size
+    // Node columns. Links hold node indices, 0 meaning none.
+    llvm::SmallVector<NodeKind, 0> kinds_;
+    llvm::SmallVector<TokenIndex, 0> token_indices_;
+    llvm::SmallVector<uint32_t, 0> parents_;
+    llvm::SmallVector<uint32_t, 0> first_children_;
+    llvm::SmallVector<uint32_t, 0> last_children_;  // Makes appending a child O(1)
+    llvm::SmallVector<uint32_t, 0> next_siblings_;
+    llvm::BitVector errors_;
+
+    llvm::ArrayRef<Token> tokens_;
+    llvm::DenseMap<size_t, size_t> deferred_bodies_;  // Placeholder index -> token index
+    llvm::SmallVector<DeclarationSpan, 16> declaration_spans_;
+
+    llvm::SmallVector<Node, 0> postorder_;
+    llvm::SmallVector<uint32_t, 0> postorder_positions_;  // Node index -> position in postorder_
+    llvm::SmallVector<uint32_t, 0> subtree_sizes_;        // Node index -> subtree size
+    llvm::SmallVector<uint64_t, 0> subtree_hashes_;       // Node index -> structural hash
+    llvm::SmallVector<uint32_t, 0> kind_offsets_;  // Kind -> first entry in kind_nodes_
+    llvm::SmallVector<Node, 0> kind_nodes_;        // Node ids grouped by kind
 
-    friend class Node;
     friend class TreeIterator;
+    friend class PreorderIterator;
+    friend class LevelOrderIterator;
     friend class ChildIterator;
 
     // Internal helper methods
-    void propagate_error(size_t index) noexcept;
-    void unlink_child(size_t parent_idx, size_t child_idx) noexcept;
+    uint32_t append_node(NodeKind kind, TokenIndex token_index);
+    void link_child(uint32_t parent, uint32_t child) noexcept;
+    void propagate_error(uint32_t index) noexcept;
+    void unlink_child(uint32_t parent, uint32_t child) noexcept;
+    void clear_postorder() noexcept;
+    // Appends the subtree of `index` to `order` in postorder, recording
+    // positions from `base` on and subtree sizes
+    void layout_subtree(uint32_t index, uint32_t base, llvm::SmallVectorImpl<Node>& order);
+    // Hashes `index` from its kind, its spelling and the hashes of its
+    // children, using `bytes` as scratch space
+    void hash_node(uint32_t index, llvm::SmallVectorImpl<char>& bytes);
+    // Roots of parallel_for_each_subtree(), and the order to run them in
+    llvm::SmallVector<Node, 0> collect_subtrees(llvm::function_ref<bool(Node)> predicate) const;
+    llvm::SmallVector<size_t, 0> schedule_subtrees(llvm::ArrayRef<Node> roots) const;
+    // Runs task(0) ... task(count - 1) on up to `jobs` threads, the caller's
+    // included, each taking the next index as it finishes the last
+    static void run_parallel(size_t count, size_t jobs, llvm::function_ref<void(size_t)> task);
+    // Drops what is derived from the links: postorder layout and hashes
+    void clear_derived() noexcept;
 };
 
-class AST::Node {
+// Post-order tree iterator over the subtree of `root`
+class AST::TreeIterator : public llvm::iterator_facade_base<TreeIterator,
+                                                            std::forward_iterator_tag,
+                                                            Node,
+                                                            ptrdiff_t,
+                                                            const Node*,
+                                                            const Node> {
 public:
-    Node() noexcept : index_(0), ast_(nullptr) {}
-
-    // Core node operations
-    [[nodiscard]] bool is_valid() const noexcept;
-    [[nodiscard]] bool has_error() const noexcept;
-    [[nodiscard]] NodeKind get_kind() const noexcept;
-    [[nodiscard]] llvm::StringRef get_spelling() const noexcept;
-    [[nodiscard]] size_t get_line() const noexcept;
+    TreeIterator() noexcept = default;
 
-    // Comparison operators
-    bool operator==(const Node& rhs) const noexcept {
-        return index_ == rhs.index_;
-    }
-    bool operator!=(const Node& rhs) const noexcept {
-        return !(*this == rhs);
-    }
-    bool operator<(const Node& rhs) const noexcept {
-        return index_ < rhs.index_;
+    bool operator==(const TreeIterator& rhs) const noexcept {
+        return node_ == rhs.node_ && ast_ == rhs.ast_;
     }
 
-    static Node create_end_node(const AST* ast) {
-        return Node(ast->nodes_.size(), ast);
+    Node operator*() const noexcept {
+        return node_;
     }
+    TreeIterator& operator++() noexcept;
+
+private:
+    friend class AST;
+
+    TreeIterator(const AST* ast, Node node, Node root) noexcept
+        : ast_(ast), node_(node), root_(root) {}
+
+    const AST* ast_{nullptr};
+    Node node_;
+    Node root_;
+};
 
-    source::SourceLocation get_location() const noexcept {
-        return {
-            ast_->get_token(*this).filename,
-            ast_->get_line(*this),
-            ast_->get_token(*this).get_column(),
-            0,
-            get_spelling().size(),
-        };
+// Pre-order tree iterator over the subtree of `root`
+class AST::PreorderIterator : public llvm::iterator_facade_base<PreorderIterator,
+                                                                std::forward_iterator_tag,
+                                                                Node,
+                                                                ptrdiff_t,
+                                                                const Node*,
+                                                                const Node> {
+public:
+    PreorderIterator() noexcept = default;
+
+    bool operator==(const PreorderIterator& rhs) const noexcept {
+        return node_ == rhs.node_ && ast_ == rhs.ast_;
     }
 
-    size_t get_index() const noexcept {
-        return index_;
+    Node operator*() const noexcept {
+        return node_;
     }
+    PreorderIterator& operator++() noexcept;
+    // Moves past the subtree of the current node, to the node the walk
+    // visits after its last descendant
+    PreorderIterator& skip_subtree() noexcept;
 
-protected:
-    Node(size_t index, const AST* ast) noexcept : index_(index), ast_(ast) {}
+private:
+    friend class AST;
 
-    size_t index_;
-    const AST* ast_;
+    PreorderIterator(const AST* ast, Node node, Node root) noexcept
+        : ast_(ast), node_(node), root_(root) {}
 
-    friend class AST;
-    friend class TreeIterator;
-    friend class ChildIterator;
+    const AST* ast_{nullptr};
+    Node node_;
+    Node root_;
 };
 
-// Post-order tree iterator
-class AST::TreeIterator : public llvm::iterator_facade_base<TreeIterator,
-                                                            std::forward_iterator_tag,
-                                                            Node,
-                                                            ptrdiff_t,
-                                                            const Node*,
-                                                            const Node> {
+// Breadth-first iterator over the subtree of `root`. It queues the visited
+// nodes whose children are still to come, so copies are not free.
+class AST::LevelOrderIterator : public llvm::iterator_facade_base<LevelOrderIterator,
+                                                                  std::forward_iterator_tag,
+                                                                  Node,
+                                                                  ptrdiff_t,
+                                                                  const Node*,
+                                                                  const Node> {
 public:
-    TreeIterator() noexcept = default;
-    TreeIterator(const AST* ast, Node node) noexcept : ast_(ast), node_(node) {}
+    LevelOrderIterator() noexcept = default;
 
-    bool operator==(const TreeIterator& rhs) const noexcept {
+    bool operator==(const LevelOrderIterator& rhs) const noexcept {
         return node_ == rhs.node_ && ast_ == rhs.ast_;
     }
 
     Node operator*() const noexcept {
         return node_;
     }
-    TreeIterator& operator++();
+    LevelOrderIterator& operator++();
 
 private:
+    friend class AST;
+
+    LevelOrderIterator(const AST* ast, Node root) noexcept
+        : ast_(ast), node_(root), root_(root) {}
+
     const AST* ast_{nullptr};
     Node node_;
-
-    // Helper methods for traversal
-    [[nodiscard]] Node find_leftmost_leaf(Node start) const noexcept;
-    [[nodiscard]] Node find_next_postorder(Node current) const noexcept;
+    Node root_;
+    std::deque<Node> parents_;  // Visited nodes whose children are not yet visited
 };
 
-// Efficient child iterator
+// Child iterator following next-sibling links
 class AST::ChildIterator : public llvm::iterator_facade_base<ChildIterator,
                                                              std::forward_iterator_tag,
                                                              Node,
@@ -183,23 +411,47 @@ public:
     ChildIterator() noexcept = default;
 
     bool operator==(const ChildIterator& rhs) const noexcept {
-        return index_ == rhs.index_ && ast_ == rhs.ast_ && node_ == rhs.node_;
+        return child_ == rhs.child_ && ast_ == rhs.ast_;
     }
 
-    Node operator*() const noexcept;
+    Node operator*() const noexcept {
+        return child_;
+    }
     ChildIterator& operator++() noexcept;
 
 private:
     friend class AST;
 
-    ChildIterator(const AST* ast, Node node, size_t index) noexcept
-        : ast_(ast), node_(node), index_(index) {}
+    ChildIterator(const AST* ast, Node child) noexcept : ast_(ast), child_(child) {}
 
     const AST* ast_{nullptr};
-    Node node_;
-    size_t index_{0};
+    Node child_;
 };
 
+template <typename Predicate, typename Function>
+auto AST::parallel_for_each_subtree(Predicate predicate, Function fn, size_t jobs) const
+    -> llvm::SmallVector<std::invoke_result_t<Function&, Node>, 0> {
+    using Result = std::invoke_result_t<Function&, Node>;
+    static_assert(!std::is_void_v<Result>, "subtree functions must return a result");
+
+    const auto roots = collect_subtrees(predicate);
+    const auto order = schedule_subtrees(roots);
+
+    // Each task writes only its own slot
+    std::vector<std::optional<Result>> results(roots.size());
+    run_parallel(order.size(), jobs, [&](size_t task) {
+        const size_t index = order[task];
+        results[index].emplace(fn(roots[index]));
+    });
+
+    llvm::SmallVector<Result, 0> ordered;
+    ordered.reserve(results.size());
+    for (auto& result : results) {
+        ordered.push_back(std::move(*result));
+    }
+    return ordered;
+}
+
 }  // namespace ziv::toolchain::ast
 
 #endif  // ZIV_TOOLCHAIN_AST_TREE_HPP
@@ -0,0 +1,132 @@
+// Part of the Ziv Programming Language, under the Apache License v2.0 with LLVM
+// See /LICENSE for license details.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef ZIV_TOOLCHAIN_AST_VISITOR_HPP
+#define ZIV_TOOLCHAIN_AST_VISITOR_HPP
+
+#include <cstdint>
+
+#include "llvm/ADT/SmallVector.h"
+#include "toolchain/ast/node_kind.hpp"
+#include "toolchain/ast/tree.hpp"
+
+namespace ziv::toolchain::ast {
+
+// What a traversal does after a pre-visit hook
+enum class VisitAction : uint8_t {
+    Continue,      // Visit the children, then post-visit the node
+    SkipChildren,  // Post-visit the node without visiting its children
+    Stop,          // End the traversal; no further hooks are called
+};
+
+// Base for passes over an AST, dispatched at compile time. `Derived` hides the
+// hooks it needs, which must be accessible from this class:
+//
+//   pre_visit_<Kind>(node)   before the children of a node of that kind,
+//                            returning what to do next
+//   post_visit_<Kind>(node)  after them
+//   pre_visit(node), post_visit(node)
+//                            for every node; by default they dispatch to
+//                            the hooks of the node's kind
+//
+// The hooks are generated from node_kind_registry.def and do nothing by
+// default, so a pass only spells out the kinds it handles. traverse() walks
+// with an explicit stack, so deep trees do not grow the call stack.
+template <typename Derived>
+class ASTVisitor {
+public:
+    // Visits the subtree of `node` in preorder, calling the post-visit hook of
+    // each node after its children. Returns false if a hook stopped it.
+    bool traverse(const AST& ast, AST::Node node) {
+        if (!ast.is_valid_node(node)) {
+            return true;
+        }
+        const AST* const outer = traversed_;  // Hooks may start traversals of their own
+        traversed_ = &ast;
+        const bool finished = walk(ast, node);
+        traversed_ = outer;
+        return finished;
+    }
+
+    // Per-node hooks, dispatching on the kind of `node`
+    VisitAction pre_visit(AST::Node node) {
+        switch (traversed_->get_kind(node).to_int()) {
+#define ZIV_NODE_KIND(NAME)         \
+    case NodeKind::NAME().to_int(): \
+        return derived().pre_visit_##NAME(node);
+#include "toolchain/ast/node_kind_registry.def"
+        }
+        return VisitAction::Continue;
+    }
+
+    void post_visit(AST::Node node) {
+        switch (traversed_->get_kind(node).to_int()) {
+#define ZIV_NODE_KIND(NAME)                \
+    case NodeKind::NAME().to_int():        \
+        derived().post_visit_##NAME(node); \
+        break;
+#include "toolchain/ast/node_kind_registry.def"
+        }
+    }
+
+    // Per-kind hooks
+#define ZIV_NODE_KIND(NAME)                            \
+    VisitAction pre_visit_##NAME(AST::Node /*node*/) { \
+        return VisitAction::Continue;                  \
+    }                                                  \
+    void post_visit_##NAME(AST::Node /*node*/) {}
+#include "toolchain/ast/node_kind_registry.def"
+
+private:
+    // The tree being traversed, for dispatching on node kinds
+    const AST* traversed_ = nullptr;
+
+    Derived& derived() {
+        return static_cast<Derived&>(*this);
+    }
+
+    bool walk(const AST& ast, AST::Node node) {
+        // One frame per node whose children are being visited
+        struct Frame {
+            AST::Node node;
+            AST::Node next_child;
+        };
+        llvm::SmallVector<Frame, 32> frames;
+
+        auto enter = [&](AST::Node entered) {
+            const VisitAction action = derived().pre_visit(entered);
+            if (action == VisitAction::Stop) {
+                return false;
+            }
+            frames.push_back({entered,
+                              action == VisitAction::Continue ? ast.get_first_child(entered)
+                                                              : AST::Node()});
+            return true;
+        };
+
+        if (!enter(node)) {
+            return false;
+        }
+        while (!frames.empty()) {
+            Frame& frame = frames.back();
+            const AST::Node child = frame.next_child;
+            if (child.is_valid()) {
+                frame.next_child = ast.get_next_sibling(child);
+                if (!enter(child)) {
+                    return false;
+                }
+                continue;
+            }
+
+            const AST::Node visited = frame.node;
+            frames.pop_back();
+            derived().post_visit(visited);
+        }
+        return true;
+    }
+};
+
+}  // namespace ziv::toolchain::ast
+
+#endif  // ZIV_TOOLCHAIN_AST_VISITOR_HPP
@@ -89,4 +89,18 @@ void ConsoleDiagnosticConsumer::consume(const Diagnostic& diagnostic) {
     print_diagnostic(diagnostic.details);
 }
 
+void BufferedDiagnosticConsumer::consume(const Diagnostic& diagnostic) {
+    const auto& metadata = diagnostic.kind.get_metadata();
+    if (metadata.severity == Severity::Error)
+        error_count_++;
+
+    diagnostics_.push_back(diagnostic);
+}
+
+void BufferedDiagnosticConsumer::replay(DiagnosticConsumer& consumer) const {
+    for (const auto& diagnostic : diagnostics_) {
+        consumer.consume(diagnostic);
+    }
+}
+
 }  // namespace ziv::toolchain::diagnostics
@@ -59,6 +59,14 @@ private:
     source::SourceExtractor source_extractor_;
 };
 
+// Holds diagnostics instead of reporting them, so work done off the main
+// thread can replay its diagnostics into another consumer in a fixed order.
+class BufferedDiagnosticConsumer : public DiagnosticConsumer {
+public:
+    void consume(const Diagnostic& diagnostic) override;
+    void replay(DiagnosticConsumer& consumer) const;
+};
+
 }  // namespace ziv::toolchain::diagnostics
 
 #endif  // ZIV_TOOLCHAIN_DIAGNOSTIC_DIAGNOSTIC_CONSUMER_HPP
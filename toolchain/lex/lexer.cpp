@@ -8,19 +8,12 @@
 
 namespace ziv::toolchain::lex {
 
-void Lexer::update_location(char c) {
-    if (c == '\n') {
-        current_loc_.line++;
-        current_loc_.column = 1;
-    } else {
-        current_loc_.column++;
-    }
-    current_loc_.offset++;
-    current_loc_.length = 1;
+void Lexer::save_location() {
+    token_start_ = cursor_;
 }
 
-void Lexer::save_location() {
-    start_loc_ = current_loc_;
+source::SourceLocation Lexer::location_at(size_t offset) const {
+    return buffer_.get_location(offset, 1);
 }
 
 
@@ -77,7 +70,7 @@ void Lexer::track_indentation() {
     // Each indentation level must be exactly indent_width_ spaces
     if (spaces % indent_width_ != 0) {
         emitter_.emit(diagnostics::DiagnosticKind::InvalidIndentation(),
-                      current_loc_,
+                      location_at(cursor_),
                       indent_width_);
         return;
     }
@@ -88,14 +81,16 @@ void Lexer::track_indentation() {
         // Only allow single level increases
         if (level != indent_level_ + 1) {
             emitter_.emit(diagnostics::DiagnosticKind::InvalidIndentation(),
-                          current_loc_,
+                          location_at(cursor_),
                           "Invalid indentation level");
             return;
         }
         indent_stack_.push_back(indent_level_);
         indent_level_ = level;
+        save_location();
         add_token(TokenKind::Indent(), "");
     } else if (level < indent_level_) {
+        save_location();
         while (!indent_stack_.empty() && level < indent_level_) {
             indent_level_ = indent_stack_.back();
             indent_stack_.pop_back();
@@ -103,7 +98,7 @@ void Lexer::track_indentation() {
         }
         if (level != indent_level_) {
             emitter_.emit(diagnostics::DiagnosticKind::InvalidIndentation(),
-                          current_loc_,
+                          location_at(cursor_),
                           "Invalid indentation level");
         }
     }
@@ -127,11 +122,13 @@ void Lexer::lex() {
         if (new_line) {
             // Add implicit semicolon if needed
             if (can_terminate_expression(last_token)) {
+                save_location();
                 add_token(TokenKind::Semicolon(), ";");
             }
             track_indentation();
         }
 
+        save_location();
         char current = peek();
         if (handlers_.count(current)) {
             (this->*handlers_[current])();
@@ -149,6 +146,8 @@ void Lexer::lex() {
         last_token = buffer_.get_last_token();
     }
 
+    save_location();
+
     // Handle final semicolon if needed
     if (can_terminate_expression(last_token)) {
         add_token(TokenKind::Semicolon(), ";");
@@ -165,24 +164,28 @@ void Lexer::lex() {
 }
 
 char Lexer::peek() const {
-    return cursor_ < source_.get_contents().size() ? source_.get_contents()[cursor_] : '\0';
+    return cursor_ < contents_.size() ? contents_[cursor_] : '\0';
 }
 
 char Lexer::peek_next() const {
-    if (cursor_ + 1 >= source_.get_contents().size())
+    if (cursor_ + 1 >= contents_.size())
         return '\0';
-    return source_.get_contents()[cursor_ + 1];
+    return contents_[cursor_ + 1];
 }
 
 char Lexer::consume() {
     char current = peek();
-    update_location(current);
     cursor_++;
+    // Every newline passes through here, so the line index is built while
+    // lexing rather than by a separate scan of the source
+    if (current == '\n') {
+        buffer_.add_line_start(cursor_);
+    }
     return current;
 }
 
 bool Lexer::is_eof() const {
-    return cursor_ >= source_.get_contents().size();
+    return cursor_ >= contents_.size();
 }
 
 bool Lexer::is_line_terminator() const {
@@ -190,7 +193,7 @@ bool Lexer::is_line_terminator() const {
 }
 
 void Lexer::add_token(TokenKind kind, llvm::StringRef spelling) {
-    buffer_.add_token(kind, spelling, current_loc_.line, current_loc_.column);
+    buffer_.add_token(kind, spelling, token_start_);
 }
 
 void Lexer::consume_whitespace() {
@@ -203,15 +206,15 @@ void Lexer::consume_comment() {
     save_location();
     consume();  // Initial '#'
 
-    if (peek() == '-' && source_.get_contents()[cursor_ + 1] == '-') {
+    if (peek() == '-' && peek_next() == '-') {
         // Multi-line comment
         consume();  // First '-'
         consume();  // Second '-'
 
         while (!is_eof()) {
-            if (peek() == '-' && cursor_ + 2 < source_.get_contents().size()
-                && source_.get_contents()[cursor_ + 1] == '-'
-                && source_.get_contents()[cursor_ + 2] == '#') {
+            if (peek() == '-' && cursor_ + 2 < contents_.size()
+                && contents_[cursor_ + 1] == '-'
+                && contents_[cursor_ + 2] == '#') {
                 consume();  // First '-'
                 consume();  // Second '-'
                 consume();  // '#'
@@ -221,7 +224,7 @@ void Lexer::consume_comment() {
         }
 
         emitter_.emit(diagnostics::DiagnosticKind::UnterminatedComment(),
-                      current_loc_,
+                      location_at(cursor_),
                       "EOF in multi-line comment");
     } else {
         // Single-line comment
@@ -252,7 +255,7 @@ void Lexer::consume_number() {
         spelling += consume();  // 'x'
         if (!std::isxdigit(peek())) {
             emitter_.emit(diagnostics::DiagnosticKind::InvalidNumber(),
-                          start_loc_,
+                          location_at(token_start_),
                           "Expected hexadecimal digit after '0x'");
             return;
         }
@@ -269,7 +272,7 @@ void Lexer::consume_number() {
         spelling += consume();  // 'b'
         if (peek() != '0' && peek() != '1') {
             emitter_.emit(diagnostics::DiagnosticKind::InvalidNumber(),
-                          start_loc_,
+                          location_at(token_start_),
                           "Expected binary digit after '0b'");
             return;
         }
@@ -298,7 +301,7 @@ void Lexer::consume_number() {
         // Must have at least one digit after decimal
         if (!std::isdigit(peek())) {
             emitter_.emit(diagnostics::DiagnosticKind::InvalidNumber(),
-                          start_loc_,
+                          location_at(token_start_),
                           "Expected digit after decimal point");
             return;
         }
@@ -321,7 +324,7 @@ void Lexer::consume_number() {
 
         if (!std::isdigit(peek())) {
             emitter_.emit(diagnostics::DiagnosticKind::InvalidNumber(),
-                          start_loc_,
+                          location_at(token_start_),
                           "Expected digit in exponent");
             return;
         }
@@ -334,7 +337,7 @@ void Lexer::consume_number() {
     // Check for invalid suffixes
     if (std::isalpha(peek()) || peek() == '_') {
         emitter_.emit(diagnostics::DiagnosticKind::InvalidNumber(),
-                      start_loc_,
+                      location_at(token_start_),
                       "Invalid number suffix");
         return;
     }
@@ -352,7 +355,7 @@ void Lexer::consume_string() {
         char c = peek();
         if (c == '\n') {
             emitter_.emit(diagnostics::DiagnosticKind::UnterminatedString(),
-                          start_loc_,
+                          location_at(token_start_),
                           "unterminated string literal");
             return;
         }
@@ -365,10 +368,10 @@ void Lexer::consume_string() {
             }
             if (c == '\\') {
                 escaped = true;
-                auto escape_loc = current_loc_;
+                size_t escape_offset = cursor_;
                 if (peek_next() == '\0') {
                     emitter_.emit(diagnostics::DiagnosticKind::InvalidEscapeSequence(),
-                                  escape_loc,
+                                  location_at(escape_offset),
                                   "incomplete escape sequence");
                     return;
                 }
@@ -395,7 +398,7 @@ void Lexer::consume_string() {
                 break;
             default:
                 emitter_.emit(diagnostics::DiagnosticKind::InvalidEscapeSequence(),
-                              current_loc_,
+                              location_at(cursor_),
                               "invalid escape sequence '\\{0}'",
                               c);
                 spelling += '\\';
@@ -408,7 +411,7 @@ void Lexer::consume_string() {
     }
 
     emitter_.emit(diagnostics::DiagnosticKind::UnterminatedString(),
-                  start_loc_,
+                  location_at(token_start_),
                   "EOF in string literal");
 }
 
@@ -419,7 +422,7 @@ void Lexer::consume_char() {
 
     if (is_eof()) {
         emitter_.emit(diagnostics::DiagnosticKind::UnterminatedCharacter(),
-                      start_loc_,
+                      location_at(token_start_),
                       "Empty character literal");
         return;
     }
@@ -429,7 +432,7 @@ void Lexer::consume_char() {
         consume();
         if (is_eof()) {
             emitter_.emit(diagnostics::DiagnosticKind::InvalidEscapeSequence(),
-                          start_loc_,
+                          location_at(token_start_),
                           "Incomplete escape sequence");
             return;
         }
@@ -452,7 +455,7 @@ void Lexer::consume_char() {
             break;
         default:
             emitter_.emit(diagnostics::DiagnosticKind::InvalidEscapeSequence(),
-                          current_loc_,
+                          location_at(cursor_),
                           "Invalid escape sequence '\\{0}'",
                           c);
             return;
@@ -464,7 +467,7 @@ void Lexer::consume_char() {
 
     if (peek() != '\'') {
         emitter_.emit(diagnostics::DiagnosticKind::UnterminatedCharacter(),
-                      start_loc_,
+                      location_at(token_start_),
                       "Multi-character char literal or unterminated char literal");
         return;
     }
@@ -505,7 +508,7 @@ void Lexer::consume_unknown() {
     save_location();
     char c = consume();
     emitter_.emit(diagnostics::DiagnosticKind::InvalidCharacter(),
-                  start_loc_,
+                  location_at(token_start_),
                   "Invalid character '{0}'",
                   c);
 }
@@ -528,12 +531,7 @@ bool Lexer::is_identifier_char(char c) const {
 }
 
 bool Lexer::can_terminate_expression(const TokenKind& kind) const {
-    return kind == TokenKind::Identifier() || kind == TokenKind::IntLiteral()
-           || kind == TokenKind::FloatLiteral() || kind == TokenKind::StringLiteral()
-           || kind == TokenKind::Break() || kind == TokenKind::Continue()
-           || kind == TokenKind::Return() || kind == TokenKind::RBrace()
-           || kind == TokenKind::RParen() || kind == TokenKind::RBracket()
-           || kind == TokenKind::Increment() || kind == TokenKind::Decrement();
+    return kind.is_terminator();
 }
 
 TokenKind Lexer::lookup_keyword(const std::string& spelling) {
@@ -21,10 +21,10 @@ public:
     Lexer(const source::SourceBuffer& source,
           std::shared_ptr<diagnostics::DiagnosticConsumer> consumer)
         : source_(source),
+          contents_(source.get_contents()),
           buffer_(source),
           cursor_(0),
-          emitter_(consumer, source),
-          current_loc_{source.get_filename(), 1, 1, 0, 0} {
+          emitter_(consumer, source) {
         initialize_handlers();
     }
 
@@ -32,18 +32,24 @@ public:
     const std::vector<TokenBuffer::Token>& get_tokens() const {
         return buffer_.get_tokens();
     }
+    const TokenBuffer& get_buffer() const {
+        return buffer_;
+    }
 
 private:
-    void update_location(char c);
-
+    // Marks the current offset as the start of the next token.
     void save_location();
 
+    // Only byte offsets are tracked while scanning; line and column are
+    // resolved through the token buffer's line index when needed.
+    source::SourceLocation location_at(size_t offset) const;
+
     const source::SourceBuffer& source_;
+    llvm::StringRef contents_;
     TokenBuffer buffer_;
     size_t cursor_;
+    size_t token_start_ = 0;
     diagnostics::DiagnosticEmitter emitter_;
-    source::SourceLocation current_loc_;
-    source::SourceLocation start_loc_;
 
     // Indentation tracking
     size_t indent_level_ = 0;
@@ -4,14 +4,129 @@
 
 #include "token_buffer.hpp"
 
+#include <algorithm>
+#include <iterator>
+
 namespace ziv::toolchain::lex {
 
-void TokenBuffer::add_token(TokenKind kind, llvm::StringRef spelling, size_t line, size_t column) {
-    tokens_.emplace_back(kind, spelling, source_buffer_.get_filename(), line, column);
+void TokenBuffer::add_token(TokenKind kind, llvm::StringRef spelling, size_t offset) {
+    // Tokens arrive in source order, so every line starting at or before this
+    // token that has not been assigned yet begins with it. The last assigned
+    // line is then the one containing the token.
+    auto index = static_cast<uint32_t>(tokens_.size());
+    while (line_first_tokens_.size() < line_offsets_.size()
+           && line_offsets_[line_first_tokens_.size()] <= offset) {
+        line_first_tokens_.push_back(index);
+    }
+
+    size_t line = line_first_tokens_.size();
+    size_t column = offset - line_offsets_[line - 1] + 1;
+    tokens_.emplace_back(kind, spelling, source_buffer_.get_filename(), line, column, offset);
+    match_token(kind, index);
+}
+
+void TokenBuffer::match_token(TokenKind kind, uint32_t index) {
+    matching_tokens_.push_back(NO_MATCH);
+
+    if (kind == TokenKind::Indent()) {
+        open_indents_.push_back(index);
+        return;
+    }
+    if (kind == TokenKind::LParen() || kind == TokenKind::LBracket()
+        || kind == TokenKind::LBrace()) {
+        open_brackets_.push_back(index);
+        return;
+    }
+
+    std::vector<uint32_t>* stack = nullptr;
+    TokenKind opener = TokenKind::Unknown();
+    if (kind == TokenKind::Dedent()) {
+        stack = &open_indents_;
+        opener = TokenKind::Indent();
+    } else if (kind == TokenKind::RParen()) {
+        stack = &open_brackets_;
+        opener = TokenKind::LParen();
+    } else if (kind == TokenKind::RBracket()) {
+        stack = &open_brackets_;
+        opener = TokenKind::LBracket();
+    } else if (kind == TokenKind::RBrace()) {
+        stack = &open_brackets_;
+        opener = TokenKind::LBrace();
+    } else {
+        return;
+    }
+
+    // Pair with the innermost opener of the same kind; any openers nested
+    // inside it are left unmatched. A closer without an opener is ignored, so
+    // a stray bracket cannot unbalance the rest of the file.
+    auto it = std::find_if(stack->rbegin(), stack->rend(), [&](uint32_t open) {
+        return tokens_[open].kind == opener;
+    });
+    if (it == stack->rend()) {
+        return;
+    }
+    matching_tokens_[*it] = index;
+    matching_tokens_[index] = *it;
+    stack->erase(std::prev(it.base()), stack->end());
 }
 
 const std::vector<TokenBuffer::Token>& TokenBuffer::get_tokens() const {
     return tokens_;
 }
 
+size_t TokenBuffer::get_line_for_offset(size_t offset) const {
+    auto it = std::upper_bound(line_offsets_.begin(), line_offsets_.end(), offset);
+    return static_cast<size_t>(it - line_offsets_.begin());
+}
+
+source::SourceLocation TokenBuffer::get_location(size_t offset, size_t length) const {
+    size_t line = get_line_for_offset(offset);
+    size_t column = offset - line_offsets_[line - 1] + 1;
+    return {source_buffer_.get_filename(), line, column, offset, length};
+}
+
+size_t TokenBuffer::get_first_token_on_line(size_t line) const {
+    if (line == 0) {
+        return 0;
+    }
+    // Lines after the last token are never assigned while lexing.
+    if (line > line_first_tokens_.size()) {
+        return tokens_.size();
+    }
+    return line_first_tokens_[line - 1];
+}
+
+llvm::ArrayRef<TokenBuffer::Token> TokenBuffer::get_line_tokens(size_t line) const {
+    if (line == 0 || line > line_offsets_.size()) {
+        return {};
+    }
+    size_t begin = get_first_token_on_line(line);
+    size_t end = get_first_token_on_line(line + 1);
+    return llvm::ArrayRef<Token>(tokens_).slice(begin, end - begin);
+}
+
+size_t TokenBuffer::get_token_at_offset(size_t offset) const {
+    if (tokens_.empty()) {
+        return 0;
+    }
+
+    // Narrow the search to the tokens of the enclosing line first; a token
+    // starting before the line (or the line being empty) is handled by
+    // stepping back one token.
+    size_t line = get_line_for_offset(offset);
+    size_t begin = get_first_token_on_line(line);
+    size_t end = std::max(begin, get_first_token_on_line(line + 1));
+
+    auto first = tokens_.begin() + static_cast<std::ptrdiff_t>(begin);
+    auto last = tokens_.begin() + static_cast<std::ptrdiff_t>(end);
+    auto it = std::upper_bound(first, last, offset, [](size_t value, const Token& token) {
+        return value < token.offset;
+    });
+
+    if (it == tokens_.begin()) {
+        return 0;
+    }
+    return static_cast<size_t>(it - tokens_.begin()) - 1;
+}
+
 }  // namespace ziv::toolchain::lex
@@ -6,8 +6,10 @@
 #define ZIV_TOOLCHAIN_LEX_TOKEN_BUFFER_HPP
 
 #include <cstdint>
+#include <optional>
 #include <vector>
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
 #include "toolchain/lex/token_kind.hpp"
 #include "toolchain/source/source_buffer.hpp"
@@ -18,25 +20,28 @@ namespace ziv::toolchain::lex {
 class TokenBuffer {
 public:
     explicit TokenBuffer(const source::SourceBuffer& source_buffer)
-        : source_buffer_(source_buffer) {}
+        : source_buffer_(source_buffer), line_offsets_{0} {}
     struct Token {
         TokenKind kind;
         std::string spelling_value;
         llvm::StringRef spelling;
         size_t line;
         size_t column;
+        size_t offset;  // Byte offset of the token start in the source buffer
         llvm::StringRef filename;
 
         Token(TokenKind kind,
               llvm::StringRef spelling,
               llvm::StringRef filename,
               size_t line,
-              size_t column)
+              size_t column,
+              size_t offset)
             : kind(kind),
               spelling_value(spelling.str()),
               spelling(spelling_value),
               line(line),
               column(column),
+              offset(offset),
               filename(filename){};
 
         Token(const Token& token)
@@ -45,14 +50,15 @@ public:
               spelling(spelling_value),
               line(token.line),
               column(token.column),
+              offset(token.offset),
               filename(token.filename) {}
 
         static Token create_empty(TokenKind kind = TokenKind::Sof()) {
-            return Token(kind, "", "", 0, 0);
+            return Token(kind, "", "", 0, 0, 0);
         }
 
         ziv::toolchain::source::SourceLocation get_location() const {
-            return {filename, line, column, /* offset */ 0, spelling.size()};
+            return {filename, line, column, offset, spelling.size()};
         };
 
         TokenKind get_kind() const {
@@ -87,13 +93,69 @@ public:
         return tokens_.empty() ? TokenKind::Sof() : tokens_.back().kind;
     }
 
-    void add_token(TokenKind kind, llvm::StringRef spelling, size_t line, size_t column);
+    // Appends a token starting at `offset`. Tokens must be added in source
+    // order; line and column are derived from the line index.
+    void add_token(TokenKind kind, llvm::StringRef spelling, size_t offset);
+
+    // Records that a line starts at `offset`, just past a newline. The lexer
+    // calls this as it consumes each newline, in source order and before any
+    // token on that line is added.
+    void add_line_start(size_t offset) {
+        line_offsets_.push_back(static_cast<uint32_t>(offset));
+    }
 
     const std::vector<Token>& get_tokens() const;
 
+    // Line index. Lines are 1-based, like `Token::line`. The index is filled in
+    // as the source is lexed, so lookups are only meaningful once lexing is done.
+    size_t get_line_count() const {
+        return line_offsets_.size();
+    }
+
+    // Returns the line containing the given byte offset.
+    size_t get_line_for_offset(size_t offset) const;
+
+    // Returns the index of the first token starting at or after the beginning
+    // of `line`. Lines without tokens map to the next token in the stream.
+    size_t get_first_token_on_line(size_t line) const;
+
+    // Returns the tokens that start on `line`.
+    llvm::ArrayRef<Token> get_line_tokens(size_t line) const;
+
+    // Returns the index of the last token starting at or before `offset`.
+    size_t get_token_at_offset(size_t offset) const;
+
+    // Resolves a byte offset into a full source location.
+    source::SourceLocation get_location(size_t offset, size_t length) const;
+
+    // Returns the index of the token paired with an `Indent`/`Dedent` or a
+    // bracket token, in either direction. Unbalanced tokens have no match.
+    std::optional<size_t> get_matching_token(size_t index) const {
+        if (index >= matching_tokens_.size() || matching_tokens_[index] == NO_MATCH) {
+            return std::nullopt;
+        }
+        return matching_tokens_[index];
+    }
+
 private:
     const ziv::toolchain::source::SourceBuffer& source_buffer_;
     std::vector<Token> tokens_;
+
+    // Byte offset at which each line starts, and the index of the first token
+    // at or after that offset. Both are stored as 32 bits to keep the index
+    // compact, which limits sources to 4 GiB.
+    std::vector<uint32_t> line_offsets_;
+    std::vector<uint32_t> line_first_tokens_;
+
+    // Index of the matching token for every token, or NO_MATCH. Indentation
+    // and brackets are tracked on separate stacks since a bracketed
+    // expression may span indented lines.
+    static constexpr uint32_t NO_MATCH = UINT32_MAX;
+    std::vector<uint32_t> matching_tokens_;
+    std::vector<uint32_t> open_indents_;
+    std::vector<uint32_t> open_brackets_;
+
+    void match_token(TokenKind kind, uint32_t index);
 };
 
 }  // namespace ziv::toolchain::lex
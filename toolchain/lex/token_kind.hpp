@@ -6,12 +6,34 @@
 #ifndef ZIV_TOOLCHAIN_LEX_TOKEN_KIND_HPP
     #define ZIV_TOOLCHAIN_LEX_TOKEN_KIND_HPP
 
+    #include <array>
+    #include <cstddef>
     #include <cstdint>
+    #include <optional>
 
     #include "llvm/ADT/StringRef.h"
 
 namespace ziv::toolchain::lex {
 
+// Precedence classes for operator tokens, loosest first. Operators of
+// different classes are only ordered when `compare_precedence` says so.
+enum class PrecedenceClass : uint8_t {
+    None,
+    LogicalOr,
+    LogicalAnd,
+    Equality,
+    Relational,
+    Bitwise,
+    Additive,
+    Multiplicative,
+};
+
+enum class Associativity : uint8_t {
+    None,
+    Left,
+    Right,
+};
+
 class TokenKind {
     enum class KindEnum : uint8_t {
     #define ZIV_TOKEN(NAME) NAME,
@@ -40,11 +62,11 @@ public:
 
     TokenKind() = delete;
 
-    bool operator==(const TokenKind& other) const {
+    constexpr bool operator==(const TokenKind& other) const {
         return kind == other.kind;
     }
 
-    bool operator!=(const TokenKind& other) const {
+    constexpr bool operator!=(const TokenKind& other) const {
         return kind != other.kind;
     }
 
@@ -53,6 +75,21 @@ public:
         return static_cast<int>(kind);
     }
 
+    // Number of token kinds in the registry
+    static constexpr size_t KIND_COUNT = 0
+    #define ZIV_TOKEN(NAME) +1
+    #include "token_kind_registry.def"
+        ;
+
+    // Inverse of the integer conversion, for kinds stored outside the
+    // process. Values follow the registry order.
+    static constexpr std::optional<TokenKind> from_int(int value) {
+        if (value < 0 || static_cast<size_t>(value) >= KIND_COUNT) {
+            return std::nullopt;
+        }
+        return TokenKind(static_cast<KindEnum>(value));
+    }
+
     llvm::StringRef get_name() const;
 
     bool is_symbol() const;
@@ -67,9 +104,57 @@ public:
     // - `TokenKind::r_paren` -> ")"
     llvm::StringRef get_spelling() const;
 
+    // Properties declared through the attributes in token_kind_registry.def.
+    // Returns true if a newline after this token ends the statement.
+    constexpr bool is_terminator() const {
+        return get_properties().terminator;
+    }
+
+    constexpr bool is_unary_operator() const {
+        return get_properties().unary;
+    }
+
+    constexpr bool is_binary_operator() const {
+        return get_properties().binary;
+    }
+
+    constexpr PrecedenceClass get_precedence_class() const {
+        return get_properties().precedence;
+    }
+
+    constexpr Associativity get_associativity() const {
+        return get_properties().associativity;
+    }
+
 private:
     constexpr TokenKind(KindEnum kind) : kind(kind) {}
 
+    struct Properties {
+        bool terminator;
+        bool unary;
+        bool binary;
+        PrecedenceClass precedence;
+        Associativity associativity;
+    };
+
+    static constexpr std::array<Properties, KIND_COUNT> PROPERTIES = [] {
+        std::array<Properties, KIND_COUNT> table{};
+    #define ZIV_TOKEN_TERMINATOR(NAME) table[static_cast<size_t>(KindEnum::NAME)].terminator = true;
+    #define ZIV_TOKEN_OPERATOR(NAME, UNARY, BINARY, PRECEDENCE, ASSOCIATIVITY)  \
+        table[static_cast<size_t>(KindEnum::NAME)].unary = UNARY;              \
+        table[static_cast<size_t>(KindEnum::NAME)].binary = BINARY;            \
+        table[static_cast<size_t>(KindEnum::NAME)].precedence =                \
+            PrecedenceClass::PRECEDENCE;                                       \
+        table[static_cast<size_t>(KindEnum::NAME)].associativity =             \
+            Associativity::ASSOCIATIVITY;
+    #include "token_kind_registry.def"
+        return table;
+    }();
+
+    constexpr const Properties& get_properties() const {
+        return PROPERTIES[static_cast<size_t>(kind)];
+    }
+
     KindEnum kind;
 };
 
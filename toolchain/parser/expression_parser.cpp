@@ -7,244 +7,196 @@
 
 namespace ziv::toolchain::parser {
 
+// Expressions are parsed without recursion: operands that nest (prefix
+// operators, parentheses and call arguments) and operators waiting for their
+// right operand live on expression_stack_, so nesting depth is bounded by
+// memory or by ParserOptions::max_nesting_depth rather than the call stack.
 ast::AST::Node Parser::parse_expression() {
-    return parse_binary_expression();
-}
-
-ast::AST::Node Parser::parse_binary_expression(int min_precedence) {
-    auto left = parse_unary();
+    const size_t base = expression_stack_.size();
+    size_t depth = 0;  // Unary, Paren and Call frames above `base`
 
     while (true) {
-        if (is_eof() || !is_binary_operator(peek().kind)) {
-            break;
+        // Operand position: descend through prefix operators and opening
+        // parentheses until a primary expression is reached.
+        ast::AST::Node operand;
+        if (is_unary_operator(peek().kind)) {
+            const size_t op_index = current_;
+            const auto op_kind = peek().kind;
+            auto unary_node = add_node(ast::NodeKind::UnaryExpr(), consume());
+            if (exceeds_nesting_limit(depth)) {
+                // The operand is still parsed, but the rest of the prefix
+                // chain is folded into this node instead of nesting further.
+                skip_nested(unary_node, op_index);
+                while (is_unary_operator(peek().kind)) {
+                    consume();
+                }
+            }
+            expression_stack_.push_back(
+                {ExpressionFrame::Kind::Unary, unary_node, op_kind, 0, false});
+            ++depth;
+            continue;
         }
 
-        auto op = peek().kind;
-
-        // Check if we should continue based on operator precedence
-        if (!should_take_operator(op, min_precedence)) {
-            break;
+        if (match(lex::TokenKind::LParen())) {
+            if (exceeds_nesting_limit(depth)) {
+                operand = add_node(ast::NodeKind::Error(), peek());
+                skip_nested(operand, current_);
+            } else {
+                consume();
+                expression_stack_.push_back({ExpressionFrame::Kind::Paren,
+                                             ast::AST::Node(),
+                                             lex::TokenKind::LParen(),
+                                             0,
+                                             false});
+                ++depth;
+                continue;
+            }
+        } else if (match(lex::TokenKind::Identifier()) && current_ + 1 < tokens_.size()
+                   && tokens_[current_ + 1].kind == lex::TokenKind::LParen()) {
+            auto call_node = add_node(ast::NodeKind::FunctionCall(), consume());
+            if (exceeds_nesting_limit(depth)) {
+                skip_nested(call_node, current_);
+                operand = call_node;
+            } else {
+                consume();  // Consume '('
+                if (consume_match(lex::TokenKind::RParen())) {
+                    operand = call_node;
+                } else {
+                    expression_stack_.push_back({ExpressionFrame::Kind::Call,
+                                                 call_node,
+                                                 lex::TokenKind::LParen(),
+                                                 0,
+                                                 false});
+                    ++depth;
+                    continue;
+                }
+            }
+        } else {
+            operand = parse_primary();
         }
 
-        // Check next operator for precedence comparison
-        size_t next_pos = current_ + 1;
-        while (next_pos < tokens_.size() && !is_binary_operator(tokens_[next_pos].kind)) {
-            next_pos++;
-        }
+        // Operator position: fold the operand into the pending frames until
+        // another operand is required or the expression is complete.
+        bool needs_operand = false;
+        while (!needs_operand) {
+            ExpressionFrame* top = expression_stack_.size() > base ? &expression_stack_.back()
+                                                                    : nullptr;
+
+            if (top && top->kind == ExpressionFrame::Kind::Unary) {
+                ast_.append_child(top->node, operand);
+                operand = top->node;
+                expression_stack_.pop_back();
+                --depth;
+                continue;
+            }
 
-        if (next_pos < tokens_.size()) {
-            auto next_op = tokens_[next_pos].kind;
-            auto prec = OperatorPrecedence::compare_precedence(op, next_op);
+            if (is_binary_operator(peek().kind)) {
+                const auto& op = peek();
+                const auto binding_power = OperatorPrecedence::get_binding_power(op.kind);
+                bool ambiguous = false;
+
+                // Each operator is compared with the operator whose right
+                // operand is being parsed, so mixed operators are caught
+                // without scanning ahead.
+                if (top && top->kind == ExpressionFrame::Kind::Binary) {
+                    ambiguous = OperatorPrecedence::compare_precedence(top->op, op.kind)
+                                == Precedence::Ambiguous;
+                    if (ambiguous) {
+                        emitter_.emit(diagnostics::DiagnosticKind::AmbiguousOperators(),
+                                      op.get_location(),
+                                      op.get_spelling(),
+                                      top->op.get_spelling());
+                    } else if (binding_power.left <= top->right_binding_power) {
+                        ast_.append_child(top->node, operand);
+                        if (top->ambiguous) {
+                            ast_.mark_error(top->node);
+                        }
+                        operand = top->node;
+                        expression_stack_.pop_back();
+                        continue;
+                    }
+                }
+
+                consume();  // Consume the operator
+                auto binary_node = add_node(
+                    ambiguous ? ast::NodeKind::Error() : ast::NodeKind::BinaryExpr(), op);
+                ast_.append_child(binary_node, operand);
+                expression_stack_.push_back({ExpressionFrame::Kind::Binary,
+                                             binary_node,
+                                             op.kind,
+                                             binding_power.right,
+                                             ambiguous});
+                needs_operand = true;
+                continue;
+            }
 
-            if (prec == Precedence::Ambiguous) {
-                auto error_node = ast_.add_node(ast::NodeKind::Error(), peek());
-                return error_node;
+            if (!top) {
+                return operand;
             }
 
-            if (prec == Precedence::RightBindsTighter) {
+            switch (top->kind) {
+            case ExpressionFrame::Kind::Binary:
+                ast_.append_child(top->node, operand);
+                if (top->ambiguous) {
+                    ast_.mark_error(top->node);
+                }
+                operand = top->node;
+                expression_stack_.pop_back();
                 break;
+            case ExpressionFrame::Kind::Paren:
+                expect(lex::TokenKind::RParen(), "Expected ')' after expression");
+                expression_stack_.pop_back();
+                --depth;
+                break;
+            case ExpressionFrame::Kind::Call:
+                if (operand.is_valid()) {
+                    ast_.append_child(top->node, operand);
+                }
+                if (consume_match(lex::TokenKind::Comma())) {
+                    needs_operand = true;  // Parse the next argument
+                    break;
+                }
+                expect(lex::TokenKind::RParen(), "Expected ')' at end of function call");
+                operand = top->node;
+                expression_stack_.pop_back();
+                --depth;
+                break;
+            case ExpressionFrame::Kind::Unary:
+                break;  // Folded above
             }
         }
-
-        consume();  // Consume the operator
-        auto binary_node = ast_.add_node(ast::NodeKind::BinaryExpr(), previous());
-        ast_.add_child(binary_node, left);
-
-        auto right = parse_binary_expression(get_operator_precedence(op) + 1);
-        ast_.add_child(binary_node, right);
-
-        left = binary_node;
-    }
-
-    return left;
-}
-
-ast::AST::Node Parser::parse_unary() {
-    if (is_unary_operator(peek().kind)) {
-        auto op = consume();
-        auto unary_node = ast_.add_node(ast::NodeKind::UnaryExpr(), op);
-        auto operand = parse_unary();  // Handle nested unary operators
-        ast_.add_child(unary_node, operand);
-        return unary_node;
     }
-
-    return parse_primary();
 }
 
 ziv::toolchain::ast::AST::Node Parser::parse_primary() {
     // Handle literals
     if (match(lex::TokenKind::IntLiteral()) || match(lex::TokenKind::FloatLiteral())
         || match(lex::TokenKind::StringLiteral()) || match(lex::TokenKind::CharLiteral())) {
-        return ast_.add_node(ast::NodeKind::LiteralExpr(), consume());
+        return add_node(ast::NodeKind::LiteralExpr(), consume());
     }
 
     // Handle booleans
     if (match(lex::TokenKind::True()) || match(lex::TokenKind::False())) {
-        return ast_.add_node(ast::NodeKind::LiteralExpr(), consume());
+        return add_node(ast::NodeKind::LiteralExpr(), consume());
     }
 
-    // Handle identifiers and function calls
+    // Handle variable references; calls and parenthesized expressions are
+    // handled by parse_expression()
     if (match(lex::TokenKind::Identifier())) {
-        auto identifier = consume();
-
-        // Check if it's a function call
-        if (match(lex::TokenKind::LParen())) {
-            return parse_function_call();
-        }
-
-        // Otherwise, it's a variable reference
-        return ast_.add_node(ast::NodeKind::IdentifierExpr(), identifier);
-    }
-
-    // Handle parenthesized expressions
-    if (consume_match(lex::TokenKind::LParen())) {
-        auto expr = parse_expression();
-        expect(lex::TokenKind::RParen(), "Expected ')' after expression");
-        return expr;
+        return add_node(ast::NodeKind::IdentifierExpr(), consume());
     }
 
     // Handle errors
-    auto error_node = ast_.add_node(ast::NodeKind::Error(), peek());
+    auto error_node = add_node(ast::NodeKind::Error(), peek());
     return error_node;
 }
 
-ziv::toolchain::ast::AST::Node Parser::parse_logical_or() {
-    auto left = parse_logical_and();
-
-    while (match(lex::TokenKind::Or())) {
-        auto op = consume();
-        auto right = parse_logical_and();
-
-        auto binary_node = ast_.add_node(ast::NodeKind::BinaryOp(), op);
-        ast_.add_child(binary_node, left);
-        ast_.add_child(binary_node, right);
-
-        left = binary_node;
-    }
-
-    return left;
-}
-
-ziv::toolchain::ast::AST::Node Parser::parse_logical_and() {
-    auto left = parse_equality();
-
-    while (match(lex::TokenKind::And())) {
-        auto op = consume();
-        auto right = parse_equality();
-
-        auto binary_node = ast_.add_node(ast::NodeKind::BinaryOp(), op);
-        ast_.add_child(binary_node, left);
-        ast_.add_child(binary_node, right);
-
-        left = binary_node;
-    }
-
-    return left;
-}
-
-ziv::toolchain::ast::AST::Node Parser::parse_equality() {
-    auto left = parse_comparison();
-
-    while (match(lex::TokenKind::DoubleEquals()) || match(lex::TokenKind::NotEquals())) {
-        auto op = consume();
-        auto right = parse_comparison();
-
-        auto binary_node = ast_.add_node(ast::NodeKind::BinaryOp(), op);
-        ast_.add_child(binary_node, left);
-        ast_.add_child(binary_node, right);
-
-        left = binary_node;
-    }
-
-    return left;
-}
-
-ziv::toolchain::ast::AST::Node Parser::parse_comparison() {
-    auto left = parse_addition();
-
-    while (match(lex::TokenKind::Less()) || match(lex::TokenKind::LessEquals())
-           || match(lex::TokenKind::Greater()) || match(lex::TokenKind::GreaterEquals())) {
-        auto op = consume();
-        auto right = parse_addition();
-
-        auto binary_node = ast_.add_node(ast::NodeKind::BinaryOp(), op);
-        ast_.add_child(binary_node, left);
-        ast_.add_child(binary_node, right);
-
-        left = binary_node;
-    }
-
-    return left;
-}
-
-ziv::toolchain::ast::AST::Node Parser::parse_addition() {
-    auto left = parse_multiplication();
-
-    while (match(lex::TokenKind::Plus()) || match(lex::TokenKind::Minus())) {
-        auto op = consume();
-        auto right = parse_multiplication();
-
-        auto binary_node = ast_.add_node(ast::NodeKind::BinaryOp(), op);
-        ast_.add_child(binary_node, left);
-        ast_.add_child(binary_node, right);
-
-        left = binary_node;
-    }
-
-    return left;
-}
-
-ziv::toolchain::ast::AST::Node Parser::parse_multiplication() {
-    auto left = parse_unary();
-
-    while (match(lex::TokenKind::Star()) || match(lex::TokenKind::Slash())
-           || match(lex::TokenKind::Percent())) {
-        auto op = consume();
-        auto right = parse_unary();
-
-        auto binary_node = ast_.add_node(ast::NodeKind::BinaryOp(), op);
-        ast_.add_child(binary_node, left);
-        ast_.add_child(binary_node, right);
-
-        left = binary_node;
-    }
-
-    return left;
-}
-
 bool Parser::is_binary_operator(lex::TokenKind kind) const {
-    return kind == lex::TokenKind::Plus() || kind == lex::TokenKind::Minus()
-           || kind == lex::TokenKind::Star() || kind == lex::TokenKind::Slash()
-           || kind == lex::TokenKind::Percent() || kind == lex::TokenKind::Pipe()
-           || kind == lex::TokenKind::Ampersand() || kind == lex::TokenKind::Caret()
-           || kind == lex::TokenKind::And() || kind == lex::TokenKind::Or();
+    return kind.is_binary_operator();
 }
 
 bool Parser::is_unary_operator(lex::TokenKind kind) const {
-    return kind == lex::TokenKind::Minus() || kind == lex::TokenKind::Not()
-           || kind == lex::TokenKind::Tilde();
-}
-
-int Parser::get_operator_precedence(lex::TokenKind op) const {
-    if (op == lex::TokenKind::Star() || op == lex::TokenKind::Slash()
-        || op == lex::TokenKind::Percent()) {
-        return 5;
-    }
-    if (op == lex::TokenKind::Plus() || op == lex::TokenKind::Minus()) {
-        return 4;
-    }
-    if (op == lex::TokenKind::Less() || op == lex::TokenKind::Greater()
-        || op == lex::TokenKind::LessEquals() || op == lex::TokenKind::GreaterEquals()) {
-        return 3;
-    }
-    if (op == lex::TokenKind::DoubleEquals() || op == lex::TokenKind::NotEquals()) {
-        return 2;
-    }
-    return 1;  // Lowest precedence for other operators
-}
-
-bool Parser::should_take_operator(lex::TokenKind op, int min_precedence) const {
-    return get_operator_precedence(op) >= min_precedence;
+    return kind.is_unary_operator();
 }
 
 }  // namespace ziv::toolchain::parser
@@ -7,41 +7,41 @@
 namespace ziv::toolchain::parser {
 
 ziv::toolchain::ast::AST::Node Parser::parse_function_declaration() {
-    auto fn_decl = ast_.add_node(ast::NodeKind::FunctionDecl(), consume());  // Consume 'fn'
+    auto fn_decl = add_node(ast::NodeKind::FunctionDecl(), consume());  // Consume 'fn'
 
     // Parse function name
     expect(lex::TokenKind::Identifier(), "Expected function name");
 
-    auto fn_name = ast_.add_node(ast::NodeKind::FunctionName(), previous());
-    ast_.add_child(fn_decl, fn_name);
+    auto fn_name = add_node(ast::NodeKind::FunctionName(), previous());
+    ast_.append_child(fn_decl, fn_name);
 
     // Parse generic parameters if present
     if (match(lex::TokenKind::LBracket())) {
         auto generic_params = parse_generic_parameters();
         if (generic_params.is_valid()) {
-            ast_.add_child(fn_decl, generic_params);
+            ast_.append_child(fn_decl, generic_params);
         }
     }
 
     // Parse parameter list
     auto params = parse_parameter_list();
     if (params.is_valid()) {
-        ast_.add_child(fn_decl, params);
+        ast_.append_child(fn_decl, params);
     }
 
     // Parse return type
     if (consume_match(lex::TokenKind::Arrow())) {
         auto return_type = parse_type_specifier();
         if (return_type.is_valid()) {
-            ast_.add_child(fn_decl, return_type);
+            ast_.append_child(fn_decl, return_type);
         }
     }
 
     // Parse function body
     if (consume_match(lex::TokenKind::Colon())) {
-        auto body = parse_block();
+        auto body = options_.outline ? defer_block() : open_block();
         if (body.is_valid()) {
-            ast_.add_child(fn_decl, body);
+            ast_.append_child(fn_decl, body);
         }
     }
 
@@ -49,8 +49,8 @@ ziv::toolchain::ast::AST::Node Parser::parse_function_declaration() {
 }
 
 ziv::toolchain::ast::AST::Node Parser::parse_generic_parameters() {
-    auto generic_params = ast_.add_node(ast::NodeKind::GenericParameters(),
-                                        consume());  // Consume '['
+    auto generic_params = add_node(ast::NodeKind::GenericParameters(),
+                                   consume());  // Consume '['
 
     while (!is_eof() && !match(lex::TokenKind::RBracket())) {
         if (!match(lex::TokenKind::Identifier())) {
@@ -60,8 +60,8 @@ ziv::toolchain::ast::AST::Node Parser::parse_generic_parameters() {
             break;
         }
 
-        auto param = ast_.add_node(ast::NodeKind::GenericParameter(), consume());
-        ast_.add_child(generic_params, param);
+        auto param = add_node(ast::NodeKind::GenericParameter(), consume());
+        ast_.append_child(generic_params, param);
 
         // Handle type constraints if present (T: Trait)
         if (match(lex::TokenKind::Colon())) {
@@ -72,8 +72,8 @@ ziv::toolchain::ast::AST::Node Parser::parse_generic_parameters() {
                               "Expected trait name after ':'");
                 break;
             }
-            auto constraint = ast_.add_node(ast::NodeKind::TypeConstraint(), consume());
-            ast_.add_child(param, constraint);
+            auto constraint = add_node(ast::NodeKind::TypeConstraint(), consume());
+            ast_.append_child(param, constraint);
         }
 
         // Handle comma separator for multiple generic parameters
@@ -92,19 +92,19 @@ ziv::toolchain::ast::AST::Node Parser::parse_generic_parameters() {
 }
 
 ziv::toolchain::ast::AST::Node Parser::parse_function_signature() {
-    auto signature_node = ast_.add_node(ast::NodeKind::FunctionSignature(), consume());
+    auto signature_node = add_node(ast::NodeKind::FunctionSignature(), consume());
 
     // Parse parameter list
     auto parameter_list = parse_parameter_list();
     if (parameter_list.is_valid()) {
-        ast_.add_child(signature_node, parameter_list);
+        ast_.append_child(signature_node, parameter_list);
     }
 
     // Parse return type
     if (consume_match(ziv::toolchain::lex::TokenKind::Arrow())) {
         expect(ziv::toolchain::lex::TokenKind::Type(), "Expected return type after '->'");
-        auto return_type = ast_.add_node(ast::NodeKind::ReturnStmt(), consume());
-        ast_.add_child(signature_node, return_type);
+        auto return_type = add_node(ast::NodeKind::ReturnStmt(), consume());
+        ast_.append_child(signature_node, return_type);
     }
 
     return signature_node;
@@ -113,23 +113,23 @@ ziv::toolchain::ast::AST::Node Parser::parse_function_signature() {
 ziv::toolchain::ast::AST::Node Parser::parse_parameter_list() {
     expect(lex::TokenKind::LParen(), "Expected '(' at start of parameter list");
 
-    auto parameter_list_node = ast_.add_node(ast::NodeKind::ParameterList(), previous());
+    auto parameter_list_node = add_node(ast::NodeKind::ParameterList(), previous());
 
     while (!is_eof() && !match(lex::TokenKind::RParen())) {
-        auto param = ast_.add_node(ast::NodeKind::Parameter(), peek());
+        auto param = add_node(ast::NodeKind::Parameter(), peek());
 
         // Parse parameter modifiers
         if (match(lex::TokenKind::Take())) {
             // Handle 'take' modifier
-            auto modifier = ast_.add_node(ast::NodeKind::ParameterModifier(), consume());
-            ast_.add_child(param, modifier);
+            auto modifier = add_node(ast::NodeKind::ParameterModifier(), consume());
+            ast_.append_child(param, modifier);
         } else if (match(lex::TokenKind::Mut())) {
             // Handle 'mut ref' case first
-            auto mut_modifier = ast_.add_node(ast::NodeKind::ParameterModifier(), consume());
+            auto mut_modifier = add_node(ast::NodeKind::ParameterModifier(), consume());
             if (match(lex::TokenKind::Ref())) {
-                auto ref_modifier = ast_.add_node(ast::NodeKind::ParameterModifier(), consume());
-                ast_.add_child(mut_modifier, ref_modifier);
-                ast_.add_child(param, mut_modifier);
+                auto ref_modifier = add_node(ast::NodeKind::ParameterModifier(), consume());
+                ast_.append_child(mut_modifier, ref_modifier);
+                ast_.append_child(param, mut_modifier);
             } else {
                 emitter_.emit(diagnostics::DiagnosticKind::UnexpectedToken(),
                               peek().get_location(),
@@ -138,8 +138,8 @@ ziv::toolchain::ast::AST::Node Parser::parse_parameter_list() {
             }
         } else if (match(lex::TokenKind::Ref())) {
             // Handle 'ref' modifier
-            auto modifier = ast_.add_node(ast::NodeKind::ParameterModifier(), consume());
-            ast_.add_child(param, modifier);
+            auto modifier = add_node(ast::NodeKind::ParameterModifier(), consume());
+            ast_.append_child(param, modifier);
         }
 
         // Parse parameter name
@@ -149,17 +149,17 @@ ziv::toolchain::ast::AST::Node Parser::parse_parameter_list() {
                           "Expected parameter name");
             break;
         }
-        auto param_name = ast_.add_node(ast::NodeKind::ParameterName(), consume());
-        ast_.add_child(param, param_name);
+        auto param_name = add_node(ast::NodeKind::ParameterName(), consume());
+        ast_.append_child(param, param_name);
 
         // Parse type annotation
         expect(lex::TokenKind::Colon(), "Expected ':' after parameter name");
         auto type = parse_type_specifier();
         if (type.is_valid()) {
-            ast_.add_child(param, type);
+            ast_.append_child(param, type);
         }
 
-        ast_.add_child(parameter_list_node, param);
+        ast_.append_child(parameter_list_node, param);
 
         if (!match(lex::TokenKind::RParen())) {
             if (!consume_match(lex::TokenKind::Comma())) {
@@ -176,35 +176,22 @@ ziv::toolchain::ast::AST::Node Parser::parse_parameter_list() {
 }
 
 ziv::toolchain::ast::AST::Node Parser::parse_function_body() {
-    auto body_node = ast_.add_node(ast::NodeKind::FunctionBody(), peek());
+    auto body_node = add_node(ast::NodeKind::FunctionBody(), peek());
 
     // Parse block
     auto block = parse_block();
     if (block.is_valid()) {
-        ast_.add_child(body_node, block);
+        ast_.append_child(body_node, block);
     }
 
     return body_node;
 }
 
 ziv::toolchain::ast::AST::Node Parser::parse_function_call() {
-    // the function call node has function name and argument list as children
-    auto function_name = consume();
-    auto function_call_node = ast_.add_node(ast::NodeKind::FunctionCall(), function_name);
-
-    expect(ziv::toolchain::lex::TokenKind::LParen(), "Expected '(' at start of function call");
-
-    // Parse argument list
-    if (!match(ziv::toolchain::lex::TokenKind::RParen())) {
-        do {
-            auto argument = parse_expression();
-            if (argument.is_valid()) {
-                ast_.add_child(function_call_node, argument);
-            }
-        } while (consume_match(ziv::toolchain::lex::TokenKind::Comma()));
-    }
+    // the function call node has function name and argument list as children;
+    // the call itself is parsed by the expression parser
+    auto function_call_node = parse_expression();
 
-    expect(ziv::toolchain::lex::TokenKind::RParen(), "Expected ')' at end of function call");
     expect(ziv::toolchain::lex::TokenKind::Semicolon(), "Expected ';' at end of function call");
 
     return function_call_node;
@@ -7,21 +7,23 @@
 namespace ziv::toolchain::parser {
 
 ziv::toolchain::ast::AST::Node Parser::parse_module_declaration() {
-    auto module_node = ast_.add_node(ast::NodeKind::ModuleDecl(), consume());
+    auto module_node = add_node(ast::NodeKind::ModuleDecl(), consume());
 
     // Parse module name
     if (!match(ziv::toolchain::lex::TokenKind::Identifier())) {
         return module_node;
     }
 
-    auto module_name = ast_.add_node(ast::NodeKind::ModuleName(), consume());
-    ast_.add_child(module_node, module_name);
+    auto module_name = add_node(ast::NodeKind::ModuleName(), consume());
+    ast_.append_child(module_node, module_name);
 
     // Parse module body
+    const size_t base = block_stack_.size();
     while (!is_eof() && !match(ziv::toolchain::lex::TokenKind::End())) {
         auto node = parse_node();
+        parse_pending_blocks(base);
         if (node.is_valid()) {
-            ast_.add_child(module_node, node);
+            ast_.append_child(module_node, node);
         }
     }
     expect(ziv::toolchain::lex::TokenKind::End(),
@@ -32,38 +34,38 @@ ziv::toolchain::ast::AST::Node Parser::parse_module_declaration() {
 }
 
 ziv::toolchain::ast::AST::Node Parser::parse_module_import() {
-    auto import_node = ast_.add_node(ast::NodeKind::ModuleImport(), consume());
+    auto import_node = add_node(ast::NodeKind::ModuleImport(), consume());
 
     // Parse module name
     if (!match(ziv::toolchain::lex::TokenKind::Identifier())) {
         return import_node;
     }
 
-    auto module_name = ast_.add_node(ast::NodeKind::ModuleName(), consume());
-    ast_.add_child(import_node, module_name);
+    auto module_name = add_node(ast::NodeKind::ModuleName(), consume());
+    ast_.append_child(import_node, module_name);
 
     // Check for alias
     if (consume_match(ziv::toolchain::lex::TokenKind::As())) {
         expect(ziv::toolchain::lex::TokenKind::Identifier(), "Expected identifier after 'as'");
-        auto alias = ast_.add_node(ast::NodeKind::ModuleAlias(), consume());
-        ast_.add_child(import_node, alias);
+        auto alias = add_node(ast::NodeKind::ModuleAlias(), previous());
+        ast_.append_child(import_node, alias);
     }
 
     // Check for specific imports
     if (consume_match(ziv::toolchain::lex::TokenKind::LBrace())) {
-        auto import_list = ast_.add_node(ast::NodeKind::ModuleImportList(), previous());
+        auto import_list = add_node(ast::NodeKind::ModuleImportList(), previous());
 
         while (!is_eof() && !match(ziv::toolchain::lex::TokenKind::RBrace())) {
             expect(ziv::toolchain::lex::TokenKind::Identifier(),
                    "Expected identifier in import list");
-            auto import = ast_.add_node(ast::NodeKind::ModuleImportItem(), consume());
-            ast_.add_child(import_list, import);
+            auto import = add_node(ast::NodeKind::ModuleImportItem(), previous());
+            ast_.append_child(import_list, import);
             if (!consume_match(ziv::toolchain::lex::TokenKind::Comma())) {
                 break;
             }
         }
         expect(ziv::toolchain::lex::TokenKind::RBrace(), "Expected '}' at end of module import");
-        ast_.add_child(import_node, import_list);
+        ast_.append_child(import_node, import_list);
     }
     return import_node;
 }
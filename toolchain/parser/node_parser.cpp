@@ -19,8 +19,12 @@ ziv::toolchain::ast::AST::Node Parser::parse_node() {
         return parse_if_statement();
     case ziv::toolchain::lex::TokenKind::While():
         return parse_while_statement();
+    case ziv::toolchain::lex::TokenKind::Module():
+        return parse_module_declaration();
+    case ziv::toolchain::lex::TokenKind::Import():
+        return parse_module_import();
     default:
-        auto invalid_node = ast_.add_node(ast::NodeKind::Invalid(), consume());
+        auto invalid_node = add_node(ast::NodeKind::Invalid(), consume());
         return invalid_node;
     }
 }
@@ -38,7 +42,7 @@ ziv::toolchain::ast::AST::Node Parser::parse_identifier() {
     if (tokens_[current_ + 1].kind == ziv::toolchain::lex::TokenKind::LParen()) {
         return parse_function_call();
     }
-    auto identifier_expr = ast_.add_node(ast::NodeKind::IdentifierExpr(), consume());
+    auto identifier_expr = add_node(ast::NodeKind::IdentifierExpr(), consume());
     return identifier_expr;
 }
 
@@ -5,6 +5,8 @@
 #ifndef ZIV_TOOLCHAIN_PARSER_OPERATOR_PRECEDENCE_HPP
 #define ZIV_TOOLCHAIN_PARSER_OPERATOR_PRECEDENCE_HPP
 
+#include <array>
+
 #include "toolchain/lex/token_kind.hpp"
 
 namespace ziv::toolchain::parser {
@@ -17,87 +19,78 @@ enum class Precedence {
 
 class OperatorPrecedence {
 public:
-    static Precedence compare_precedence(ziv::toolchain::lex::TokenKind left,
-                                         ziv::toolchain::lex::TokenKind right) {
-        // Multiplication and division bind tighter than addition and subtraction
-        if ((is_multiplicative(left) && is_additive(right))
-            || (is_multiplicative(left) && is_bitwise(right))
-            || (is_additive(left) && is_bitwise(right))) {
-            return Precedence::LeftBindsTighter;
-        }
-
-        if ((is_additive(left) && is_multiplicative(right))
-            || (is_bitwise(left) && is_multiplicative(right))
-            || (is_bitwise(left) && is_additive(right))) {
-            return Precedence::RightBindsTighter;
-        }
-
-        // Same precedence level operators
-        if (is_multiplicative(left) && is_multiplicative(right)) {
-            return Precedence::LeftBindsTighter;  // Left associative
-        }
-        if (is_additive(left) && is_additive(right)) {
-            return Precedence::LeftBindsTighter;  // Left associative
+    static constexpr Precedence compare_precedence(ziv::toolchain::lex::TokenKind left,
+                                                   ziv::toolchain::lex::TokenKind right) {
+        auto left_class = left.get_precedence_class();
+        auto right_class = right.get_precedence_class();
+
+        // Operators of the same class group according to their associativity;
+        // non-associative classes (bitwise, comparisons) require parentheses.
+        if (left_class == right_class) {
+            if (left_class == ziv::toolchain::lex::PrecedenceClass::None) {
+                return Precedence::Ambiguous;
+            }
+            switch (left.get_associativity()) {
+            case ziv::toolchain::lex::Associativity::Left:
+                return Precedence::LeftBindsTighter;
+            case ziv::toolchain::lex::Associativity::Right:
+                return Precedence::RightBindsTighter;
+            case ziv::toolchain::lex::Associativity::None:
+                return Precedence::Ambiguous;
+            }
         }
 
-        // Bitwise operations with mixed arithmetic require explicit parentheses
-        if ((is_bitwise(left) && is_bitwise(right)) || (is_bitwise(left) && is_arithmetic(right))
-            || (is_arithmetic(left) && is_bitwise(right))) {
+        // Multiplication binds tighter than addition, which binds tighter than
+        // bitwise operators. Everything else must be parenthesized.
+        int left_rank = get_arithmetic_rank(left_class);
+        int right_rank = get_arithmetic_rank(right_class);
+        if (left_rank == 0 || right_rank == 0) {
             return Precedence::Ambiguous;
         }
+        return left_rank > right_rank ? Precedence::LeftBindsTighter
+                                      : Precedence::RightBindsTighter;
+    }
 
-        // Comparison operators
-        if (is_comparison(left) || is_comparison(right)) {
-            return Precedence::Ambiguous;  // Always require parentheses for clarity
-        }
-
-        // Logical operators
-        if (is_logical(left) && is_logical(right)) {
-            if (left == right) {
-                return Precedence::LeftBindsTighter;  // Left associative
-            }
-            // Different logical operators require explicit precedence
-            return Precedence::Ambiguous;
+    // Binding powers for precedence climbing: an operator is taken while its
+    // left power exceeds the current minimum, and its right operand is parsed
+    // with the right power as the new minimum.
+    struct BindingPower {
+        int left;
+        int right;
+    };
+
+    static constexpr BindingPower get_binding_power(ziv::toolchain::lex::TokenKind op) {
+        constexpr std::array<int, 8> LEVELS = {
+            0,  // None
+            1,  // LogicalOr
+            2,  // LogicalAnd
+            3,  // Equality
+            4,  // Relational
+            5,  // Bitwise
+            6,  // Additive
+            7,  // Multiplicative
+        };
+        int left = LEVELS[static_cast<size_t>(op.get_precedence_class())] * 2;
+        if (op.get_associativity() == ziv::toolchain::lex::Associativity::Right) {
+            return {left, left - 1};
         }
-
-        return Precedence::Ambiguous;
+        return {left, left + 1};
     }
 
 private:
-    static bool is_multiplicative(ziv::toolchain::lex::TokenKind kind) {
-        return kind == ziv::toolchain::lex::TokenKind::Star()
-               || kind == ziv::toolchain::lex::TokenKind::Slash()
-               || kind == ziv::toolchain::lex::TokenKind::Percent();
-    }
-
-    static bool is_additive(ziv::toolchain::lex::TokenKind kind) {
-        return kind == ziv::toolchain::lex::TokenKind::Plus()
-               || kind == ziv::toolchain::lex::TokenKind::Minus();
-    }
-
-    static bool is_bitwise(ziv::toolchain::lex::TokenKind kind) {
-        return kind == ziv::toolchain::lex::TokenKind::Pipe()
-               || kind == ziv::toolchain::lex::TokenKind::Ampersand()
-               || kind == ziv::toolchain::lex::TokenKind::Caret();
-    }
-
-    static bool is_comparison(ziv::toolchain::lex::TokenKind kind) {
-        return kind == ziv::toolchain::lex::TokenKind::Less()
-               || kind == ziv::toolchain::lex::TokenKind::Greater()
-               || kind == ziv::toolchain::lex::TokenKind::LessEquals()
-               || kind == ziv::toolchain::lex::TokenKind::GreaterEquals()
-               || kind == ziv::toolchain::lex::TokenKind::DoubleEquals()
-               || kind == ziv::toolchain::lex::TokenKind::NotEquals();
-    }
-
-    static bool is_logical(ziv::toolchain::lex::TokenKind kind) {
-        return kind == ziv::toolchain::lex::TokenKind::And()
-               || kind == ziv::toolchain::lex::TokenKind::Or()
-               || kind == ziv::toolchain::lex::TokenKind::Not();
-    }
-
-    static bool is_arithmetic(ziv::toolchain::lex::TokenKind kind) {
-        return is_multiplicative(kind) || is_additive(kind);
+    // Position of a class in the arithmetic ordering, or 0 if it has none.
+    static constexpr int get_arithmetic_rank(ziv::toolchain::lex::PrecedenceClass precedence) {
+        constexpr std::array<int, 8> RANKS = {
+            0,  // None
+            0,  // LogicalOr
+            0,  // LogicalAnd
+            0,  // Equality
+            0,  // Relational
+            1,  // Bitwise
+            2,  // Additive
+            3,  // Multiplicative
+        };
+        return RANKS[static_cast<size_t>(precedence)];
     }
 };
 
@@ -4,28 +4,221 @@
 
 #include "parser.hpp"
 
+#include <algorithm>
+#include <thread>
+
 #include "toolchain/diagnostics/compilation_phase.hpp"
 
 namespace ziv::toolchain::parser {
 
+namespace {
+
+bool is_declaration_start(lex::TokenKind kind) {
+    return kind == lex::TokenKind::Fn() || kind == lex::TokenKind::Let()
+        || kind == lex::TokenKind::Var() || kind == lex::TokenKind::Module()
+        || kind == lex::TokenKind::Import();
+}
+
+// An edit between two token streams: `removed` tokens of the previous
+// stream starting at `begin` were replaced by `inserted` tokens.
+struct TokenSplice {
+    size_t begin;
+    size_t removed;
+    size_t inserted;
+};
+
+// The smallest splice turning `before` into `after`: everything but their
+// common prefix and suffix of tokens with the same kind and spelling.
+TokenSplice find_splice(llvm::ArrayRef<lex::TokenBuffer::Token> before,
+                        llvm::ArrayRef<lex::TokenBuffer::Token> after) {
+    auto same = [](const lex::TokenBuffer::Token& lhs, const lex::TokenBuffer::Token& rhs) {
+        return lhs.kind == rhs.kind && lhs.get_spelling() == rhs.get_spelling();
+    };
+    const size_t common = std::min(before.size(), after.size());
+    size_t prefix = 0;
+    while (prefix < common && same(before[prefix], after[prefix])) {
+        ++prefix;
+    }
+    size_t suffix = 0;
+    while (prefix + suffix < common
+           && same(before[before.size() - 1 - suffix], after[after.size() - 1 - suffix])) {
+        ++suffix;
+    }
+    return {prefix, before.size() - prefix - suffix, after.size() - prefix - suffix};
+}
+
+}  // namespace
+
 void Parser::parse() {
     diagnostics::PhaseGuard guard(diagnostics::CompilationPhase::Parsing);
-    auto root = ast_.add_node(ast::NodeKind::FileStart(), consume());
+    auto root = add_node(ast::NodeKind::FileStart(), consume());
 
     // Parse all declarations
+    size_t jobs = options_.jobs;
+    if (jobs == 0) {
+        jobs = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    if (jobs > 1) {
+        parse_declarations_in_parallel(root, jobs);
+    } else {
+        llvm::SmallVector<ast::AST::Node, 16> nodes;
+        parse_declarations(nodes);
+        for (auto node : nodes) {
+            ast_.append_child(root, node);
+        }
+    }
+
+    auto eof = add_node(ast::NodeKind::FileEnd(), tokens_.back());
+    ast_.append_child(root, eof);
+    ast_.layout_postorder();
+    if (options_.subtree_hashes) {
+        ast_.compute_subtree_hashes();
+    }
+}
+
+void Parser::reparse(const lex::TokenBuffer& previous_tokens) {
+    const auto spans = ast_.get_declaration_spans();
+    if (ast_.empty() || spans.empty()) {
+        ast_ = ast::AST();
+        ast_.set_tokens(tokens_);
+        parse();
+        return;
+    }
+
+    diagnostics::PhaseGuard guard(diagnostics::CompilationPhase::Parsing);
+    const TokenSplice splice = find_splice(previous_tokens.get_tokens(), tokens_);
+    const ptrdiff_t token_shift = static_cast<ptrdiff_t>(splice.inserted)
+                                - static_cast<ptrdiff_t>(splice.removed);
+
+    // Declarations before the edit are kept as long as the token after them,
+    // which parsing may have looked at, is unchanged too
+    size_t first = 0;
+    while (first < spans.size() && spans[first].end < splice.begin) {
+        ++first;
+    }
+
+    // Parse into a fragment until a declaration starts where one started in
+    // the previous tokens past the edit; from there on the two parses agree
+    ast::AST fragment;
+    Parser parser(buffer_, fragment, consumer_, source_, options_);
+    parser.current_ = first < spans.size() ? spans[first].begin : end_;
+    size_t last = first;
+    llvm::SmallVector<ast::AST::Node, 16> nodes;
+    while (!parser.is_eof()) {
+        if (parser.current_ >= splice.begin + splice.inserted) {
+            const size_t previous_index = static_cast<size_t>(
+                static_cast<ptrdiff_t>(parser.current_) - token_shift);
+            while (last < spans.size() && spans[last].begin < previous_index) {
+                ++last;
+            }
+            if (last < spans.size() && spans[last].begin == previous_index) {
+                break;
+            }
+        }
+        parser.parse_declaration(nodes);
+    }
+    if (parser.is_eof()) {
+        last = spans.size();
+    }
+
+    ast_.splice_declarations(first, last, std::move(fragment), token_shift);
+    if (options_.subtree_hashes && !ast_.has_subtree_hashes()) {
+        ast_.compute_subtree_hashes();
+    }
+}
+
+void Parser::parse_declarations(llvm::SmallVectorImpl<ast::AST::Node>& nodes) {
     while (!is_eof()) {
-        auto node = parse_node();
-        if (node.is_valid()) {
-            ast_.add_child(root, node);
+        parse_declaration(nodes);
+    }
+}
+
+void Parser::parse_declaration(llvm::SmallVectorImpl<ast::AST::Node>& nodes) {
+    const size_t begin = current_;
+    auto node = parse_node();
+    parse_pending_blocks();
+    while (match(lex::TokenKind::Semicolon())) {
+        consume();
+    }
+
+    if (node.is_valid()) {
+        nodes.push_back(node);
+    }
+    ast_.add_declaration_span(begin, current_, node);
+}
+
+void Parser::parse_declarations_in_parallel(ast::AST::Node root, size_t jobs) {
+    struct Fragment {
+        ast::AST ast;
+        std::shared_ptr<diagnostics::BufferedDiagnosticConsumer> diagnostics;
+        llvm::SmallVector<ast::AST::Node, 16> nodes;
+    };
+
+    const auto ranges = partition_declarations(jobs);
+    std::vector<Fragment> fragments(ranges.size());
+
+    auto parse_range = [&](size_t index) {
+        auto& fragment = fragments[index];
+        fragment.diagnostics = std::make_shared<diagnostics::BufferedDiagnosticConsumer>();
+
+        Parser parser(buffer_, fragment.ast, fragment.diagnostics, source_, options_);
+        parser.current_ = ranges[index].first;
+        parser.end_ = ranges[index].second;
+        parser.parse_declarations(fragment.nodes);
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(ranges.size() - 1);
+    for (size_t index = 1; index < ranges.size(); ++index) {
+        workers.emplace_back(parse_range, index);
+    }
+    parse_range(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Fragments are stitched in source order, so node indices and the order
+    // of diagnostics are the same as for a sequential parse.
+    for (auto& fragment : fragments) {
+        const size_t offset = ast_.append(std::move(fragment.ast));
+        for (auto node : fragment.nodes) {
+            ast_.append_child(root, ast_.get_node(node.get_index() + offset));
         }
-        while (match(lex::TokenKind::Semicolon())) {
-            consume();
+        fragment.diagnostics->replay(*consumer_);
+    }
+}
+
+// Splits the remaining tokens into at most `jobs` ranges of whole top-level
+// declarations with similar token counts. Indented blocks and brackets are
+// skipped through their matching tokens, as nothing inside them is top-level,
+// and module bodies are never split.
+std::vector<std::pair<size_t, size_t>> Parser::partition_declarations(size_t jobs) const {
+    const size_t target = std::max<size_t>((end_ - current_) / jobs, 1);
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    size_t range_begin = current_;
+    size_t module_depth = 0;  // Declarations inside `module ... end module` stay together
+    for (size_t index = current_; index < end_;) {
+        const auto& token = tokens_[index];
+        if (module_depth == 0 && index - range_begin >= target && ranges.size() + 1 < jobs
+            && token.get_column() == 1 && is_declaration_start(token.kind)) {
+            ranges.emplace_back(range_begin, index);
+            range_begin = index;
+        }
+        if (token.kind == lex::TokenKind::Module()) {
+            if (index > 0 && tokens_[index - 1].kind == lex::TokenKind::End()) {
+                module_depth -= module_depth > 0 ? 1 : 0;
+            } else {
+                ++module_depth;
+            }
         }
+
+        auto close = buffer_.get_matching_token(index);
+        index = close && *close > index ? *close + 1 : index + 1;
     }
-    auto eof = ast_.add_node(ast::NodeKind::FileEnd(),
-                             toolchain::lex::TokenBuffer::Token::create_empty(
-                                 toolchain::lex::TokenKind::Eof()));
-    ast_.add_child(root, eof);
+    ranges.emplace_back(range_begin, end_);
+    return ranges;
 }
 
 }  // namespace ziv::toolchain::parser
@@ -6,10 +6,14 @@
 #ifndef ZIV_TOOLCHAIN_PARSER_PARSER_HPP
     #define ZIV_TOOLCHAIN_PARSER_PARSER_HPP
 
+    #include <cstdint>
     #include <iostream>
     #include <memory>
+    #include <utility>
     #include <vector>
 
+    #include "llvm/ADT/ArrayRef.h"
+    #include "llvm/ADT/SmallVector.h"
     #include "llvm/ADT/StringRef.h"
     #include "llvm/Support/raw_ostream.h"
     #include "toolchain/ast/tree.hpp"
@@ -19,22 +23,76 @@
     #include "toolchain/source/source_buffer.hpp"
 
 namespace ziv::toolchain::parser {
+
+struct ParserOptions {
+    // Deepest nesting of blocks, and of unary, parenthesized and call
+    // expressions, before the parser reports NestingTooDeep and skips the
+    // construct. Zero leaves nesting limited only by memory.
+    size_t max_nesting_depth = 0;
+
+    // Threads used to parse top-level declarations. Declarations start at
+    // column 1 outside any indented block or bracket, so they are split there,
+    // parsed into separate node arenas and stitched back in source order. One
+    // parses sequentially; zero uses one thread per hardware thread.
+    size_t jobs = 1;
+
+    // Outline mode: function bodies are skipped through the lexer's matching
+    // Dedent and left as Placeholder nodes, to be parsed on demand with
+    // Parser::parse_deferred_body().
+    bool outline = false;
+
+    // Compute structural subtree hashes once the tree is complete (see
+    // AST::compute_subtree_hashes()).
+    bool subtree_hashes = false;
+};
+
 class Parser {
 public:
-    Parser(std::vector<ziv::toolchain::lex::TokenBuffer::Token> tokens,
+    // The parser reads tokens in place from `buffer` without copying them, and
+    // the nodes it adds to `ast` refer to them, so the buffer (and the lexer
+    // owning it) must outlive both and must not be modified while parsing.
+    Parser(const ziv::toolchain::lex::TokenBuffer& buffer,
            ziv::toolchain::ast::AST& ast,
            std::shared_ptr<diagnostics::DiagnosticConsumer> consumer,
-           const source::SourceBuffer& source)
-        : tokens_(std::move(tokens)), ast_(ast), current_(0), emitter_(consumer, source) {}
+           const source::SourceBuffer& source,
+           ParserOptions options = {})
+        : buffer_(buffer),
+          tokens_(buffer.get_tokens()),
+          ast_(ast),
+          current_(0),
+          end_(tokens_.size()),
+          source_(source),
+          consumer_(consumer),
+          emitter_(consumer, source),
+          options_(options) {
+        ast_.set_tokens(tokens_);
+    }
 
     void parse();
 
+    // Parses this parser's buffer after an edit, updating in place the tree
+    // in `ast`, which was parsed from `previous_tokens`. The edit is what
+    // lies between the tokens the two buffers share at either end. Top-level
+    // declarations whose tokens, and the token after them, lie outside it
+    // keep their nodes, and their diagnostics are not reported again; only
+    // the declarations in between are parsed, laid out and hashed (see
+    // AST::splice_declarations()).
+    void reparse(const ziv::toolchain::lex::TokenBuffer& previous_tokens);
+
+    // Parses a function body left as `placeholder` by an outline parse and
+    // puts the resulting CodeBlock in its place. Returns an invalid node if
+    // `placeholder` has no deferred body. Like any relinking, this drops the
+    // tree's postorder layout and hashes; lay the tree out again once the
+    // bodies needed are parsed.
+    ziv::toolchain::ast::AST::Node parse_deferred_body(
+        ziv::toolchain::ast::AST::Node placeholder);
+
     ziv::toolchain::ast::AST& get_ast() {
         return ast_;
     }
 
     bool is_eof() const {
-        return current_ >= tokens_.size();
+        return current_ >= end_;
     }
 
     bool match(ziv::toolchain::lex::TokenKind kind) const;
@@ -49,14 +107,44 @@ public:
 
     bool consume_match(ziv::toolchain::lex::TokenKind kind);
 
-    ziv::toolchain::ast::AST::Node parse_binary_expression(int min_precedence = 0);
     bool is_binary_operator(ziv::toolchain::lex::TokenKind kind) const;
     bool is_unary_operator(ziv::toolchain::lex::TokenKind kind) const;
-    int get_operator_precedence(ziv::toolchain::lex::TokenKind op) const;
-    bool should_take_operator(ziv::toolchain::lex::TokenKind op, int min_precedence) const;
 
 private:
+    // Pending work of the block parser. Statements that own a block push a
+    // Statements frame for it, beneath any continuation that has to run once
+    // the block is closed, and return; parse_pending_blocks() drains the stack
+    // so nested blocks never recurse.
+    struct BlockFrame {
+        enum class Kind : uint8_t {
+            Statements,   // Statements of the CodeBlock `node` up to its Dedent
+            ElseClause,   // Optional else/else-if following the IfStatement `node`
+            DoWhileTail,  // Trailing `while <condition>` of the DoWhileLoop `node`
+            MatchCases,   // Cases of the MatchStmt `node` up to `end`
+        };
+
+        Kind kind;
+        ziv::toolchain::ast::AST::Node node;
+    };
+
+    // Pending operators of the expression parser. Prefix operators,
+    // parentheses and call arguments nest through this stack, and a Binary
+    // frame holds an operator whose right operand is still being parsed.
+    struct ExpressionFrame {
+        enum class Kind : uint8_t { Unary, Binary, Paren, Call };
+
+        Kind kind;
+        ziv::toolchain::ast::AST::Node node;  // Invalid for Paren
+        ziv::toolchain::lex::TokenKind op;    // Operator, or '(' for Paren and Call
+        int right_binding_power;              // Binary only
+        bool ambiguous;                       // Binary only
+    };
+
     // Top-level parsing
+    void parse_declarations(llvm::SmallVectorImpl<ziv::toolchain::ast::AST::Node>& nodes);
+    void parse_declaration(llvm::SmallVectorImpl<ziv::toolchain::ast::AST::Node>& nodes);
+    void parse_declarations_in_parallel(ziv::toolchain::ast::AST::Node root, size_t jobs);
+    std::vector<std::pair<size_t, size_t>> partition_declarations(size_t jobs) const;
     ziv::toolchain::ast::AST::Node parse_node();
     ziv::toolchain::ast::AST::Node parse_module_declaration();
     ziv::toolchain::ast::AST::Node parse_module_import();
@@ -72,18 +160,23 @@ private:
     // Statement parsing
     ziv::toolchain::ast::AST::Node parse_statement();
     ziv::toolchain::ast::AST::Node parse_block();
+    ziv::toolchain::ast::AST::Node open_block();
+    ziv::toolchain::ast::AST::Node defer_block();
+    void parse_pending_blocks(size_t base = 0);
     ziv::toolchain::ast::AST::Node parse_variable_declaration();
     // Control flow parsing
     ziv::toolchain::ast::AST::Node parse_if_statement();
     ziv::toolchain::ast::AST::Node parse_if_else();
     ziv::toolchain::ast::AST::Node parse_else_statement();
     ziv::toolchain::ast::AST::Node parse_else_if_statement();
+    void parse_else_clause(ziv::toolchain::ast::AST::Node if_node);
     ziv::toolchain::ast::AST::Node parse_match_statement();
     ziv::toolchain::ast::AST::Node parse_match_case();
     // Loop parsing
     ziv::toolchain::ast::AST::Node parse_for_statement();
     ziv::toolchain::ast::AST::Node parse_while_statement();
     ziv::toolchain::ast::AST::Node parse_do_while_statement();
+    void parse_do_while_condition(ziv::toolchain::ast::AST::Node do_while_node);
     ziv::toolchain::ast::AST::Node parse_try_handle_statement();
     ziv::toolchain::ast::AST::Node parse_return_statement();
     ziv::toolchain::ast::AST::Node parse_break_statement();
@@ -92,18 +185,10 @@ private:
     // Expression parsing
     ziv::toolchain::ast::AST::Node parse_delimiter();
     ziv::toolchain::ast::AST::Node parse_expression();
-    ziv::toolchain::ast::AST::Node parse_assignment();
-    ziv::toolchain::ast::AST::Node parse_logical_or();
-    ziv::toolchain::ast::AST::Node parse_logical_and();
     ziv::toolchain::ast::AST::Node parse_logical_not();
-    ziv::toolchain::ast::AST::Node parse_equality();
-    ziv::toolchain::ast::AST::Node parse_comparison();
     ziv::toolchain::ast::AST::Node parse_term();
     ziv::toolchain::ast::AST::Node parse_factor();
-    ziv::toolchain::ast::AST::Node parse_unary();
     ziv::toolchain::ast::AST::Node parse_primary();
-    ziv::toolchain::ast::AST::Node parse_addition();
-    ziv::toolchain::ast::AST::Node parse_multiplication();
     ziv::toolchain::ast::AST::Node parse_precedence_expression();
 
     // Type parsing
@@ -115,12 +200,24 @@ private:
     void synchronize();  // Error recovery
     void expect(lex::TokenKind kind, const llvm::StringRef& message);
     ziv::toolchain::ast::AST::Node parse_identifier();
+    ziv::toolchain::ast::AST::Node add_node(ziv::toolchain::ast::NodeKind kind,
+                                            const ziv::toolchain::lex::TokenBuffer::Token& token);
+    bool exceeds_nesting_limit(size_t depth) const;
+    void skip_nested(ziv::toolchain::ast::AST::Node node, size_t open_index);
 
     // Class members
-    std::vector<ziv::toolchain::lex::TokenBuffer::Token> tokens_;
+    const ziv::toolchain::lex::TokenBuffer& buffer_;
+    llvm::ArrayRef<ziv::toolchain::lex::TokenBuffer::Token> tokens_;
     ziv::toolchain::ast::AST& ast_;
     size_t current_;
+    size_t end_;  // Tokens from here on are left to other parsers
+    const source::SourceBuffer& source_;
+    std::shared_ptr<diagnostics::DiagnosticConsumer> consumer_;
     diagnostics::DiagnosticEmitter emitter_;
+    ParserOptions options_;
+    std::vector<BlockFrame> block_stack_;
+    std::vector<ExpressionFrame> expression_stack_;
+    size_t block_depth_ = 0;
 };
 
 }  // namespace ziv::toolchain::parser
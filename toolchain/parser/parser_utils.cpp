@@ -4,6 +4,9 @@
 
 #include "parser.hpp"
 
+#include <algorithm>
+#include <functional>
+
 namespace ziv::toolchain::parser {
 
 void Parser::synchronize() {
@@ -43,21 +46,22 @@ const lex::TokenBuffer::Token& Parser::consume() {
     if (!is_eof()) {
         return tokens_[current_++];
     }
-    return tokens_[current_];
+    return tokens_.back();
 }
 
+// Past the end of the stream, peek() keeps returning the final Eof token.
 const lex::TokenBuffer::Token& Parser::peek() const {
     if (!is_eof()) {
         return tokens_[current_];
     }
-    return tokens_[current_];
+    return tokens_.back();
 }
 
 const lex::TokenBuffer::Token& Parser::previous() const {
     if (current_ > 0) {
-        return tokens_[current_ - 1];
+        return tokens_[std::min(current_, tokens_.size()) - 1];
     }
-    return tokens_[current_];
+    return tokens_.front();
 }
 
 bool Parser::consume_match(lex::TokenKind kind) {
@@ -68,9 +72,38 @@ bool Parser::consume_match(lex::TokenKind kind) {
     return false;
 }
 
+// Tokens handed out by consume(), peek() and previous() live in tokens_, so
+// their index follows from their address.
+ast::AST::Node Parser::add_node(ast::NodeKind kind, const lex::TokenBuffer::Token& token) {
+    const bool in_buffer = std::less_equal<>()(tokens_.begin(), &token)
+                        && std::less<>()(&token, tokens_.end());
+    return ast_.add_node(kind,
+                         in_buffer ? static_cast<ast::AST::TokenIndex>(&token - tokens_.begin())
+                                   : ast::AST::NO_TOKEN);
+}
+
+bool Parser::exceeds_nesting_limit(size_t depth) const {
+    return options_.max_nesting_depth != 0 && depth >= options_.max_nesting_depth;
+}
+
+// Reports a construct nested past the limit and skips to the token matching
+// the one at `open_index`, so the parser resumes after it.
+void Parser::skip_nested(ast::AST::Node node, size_t open_index) {
+    emitter_.emit(diagnostics::DiagnosticKind::NestingTooDeep(),
+                  tokens_[open_index].get_location(),
+                  options_.max_nesting_depth);
+    ast_.mark_error(node);
+
+    if (auto close = buffer_.get_matching_token(open_index)) {
+        current_ = *close + 1;
+    } else if (current_ == open_index) {
+        consume();
+    }
+}
+
 void Parser::expect(lex::TokenKind kind, const llvm::StringRef& message) {
     if (!consume_match(kind)) {
-        ast_.mark_error(ast_.add_node(ast::NodeKind::Error(), peek()));
+        ast_.mark_error(add_node(ast::NodeKind::Error(), peek()));
         emitter_.emit(diagnostics::DiagnosticKind::UnexpectedToken(),
                       peek().get_location(),
                       peek().get_spelling(),
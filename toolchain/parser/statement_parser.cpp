@@ -33,68 +33,152 @@ ziv::toolchain::ast::AST::Node Parser::parse_statement() {
 }
 
 ziv::toolchain::ast::AST::Node Parser::parse_block() {
+    const size_t base = block_stack_.size();
+    auto block_node = open_block();
+    parse_pending_blocks(base);
+    return block_node;
+}
+
+ziv::toolchain::ast::AST::Node Parser::open_block() {
     // Consume the indent token
-    auto block_node = ast_.add_node(ast::NodeKind::CodeBlock(), consume());
+    const size_t indent_index = current_;
+    auto block_node = add_node(ast::NodeKind::CodeBlock(), consume());
 
-    // Parse statements until we hit a dedent
-    while (!is_eof() && !match(lex::TokenKind::Dedent())) {
-        auto statement = parse_statement();
-        if (statement.is_valid()) {
-            ast_.add_child(block_node, statement);
-        }
+    if (exceeds_nesting_limit(block_depth_)) {
+        skip_nested(block_node, indent_index);
+        return block_node;
     }
 
-    expect(lex::TokenKind::Dedent(), "Expected dedent at end of block");
+    block_stack_.push_back({BlockFrame::Kind::Statements, block_node});
+    ++block_depth_;
     return block_node;
 }
 
+ziv::toolchain::ast::AST::Node Parser::defer_block() {
+    const size_t indent_index = current_;
+    auto close = buffer_.get_matching_token(indent_index);
+    if (!match(lex::TokenKind::Indent()) || !close) {
+        return open_block();
+    }
+
+    auto placeholder = add_node(ast::NodeKind::Placeholder(), consume());
+    ast_.defer_body(placeholder, indent_index);
+    current_ = *close + 1;  // Resume after the body's dedent
+    return placeholder;
+}
+
+ziv::toolchain::ast::AST::Node Parser::parse_deferred_body(
+    ziv::toolchain::ast::AST::Node placeholder) {
+    auto indent_index = ast_.get_deferred_body(placeholder);
+    if (!indent_index) {
+        return ast::AST::Node();
+    }
+
+    current_ = *indent_index;
+    end_ = tokens_.size();
+    auto block = parse_block();
+    ast_.replace(placeholder, block);
+    return block;
+}
+
+void Parser::parse_pending_blocks(size_t base) {
+    while (block_stack_.size() > base) {
+        // Copied, since parsing a statement may push frames of its own
+        const BlockFrame frame = block_stack_.back();
+
+        switch (frame.kind) {
+        case BlockFrame::Kind::Statements: {
+            // Parse statements until we hit a dedent
+            if (is_eof() || match(lex::TokenKind::Dedent())) {
+                expect(lex::TokenKind::Dedent(), "Expected dedent at end of block");
+                block_stack_.pop_back();
+                --block_depth_;
+                break;
+            }
+
+            const size_t start = current_;
+            auto statement = parse_statement();
+            if (statement.is_valid()) {
+                ast_.append_child(frame.node, statement);
+            }
+            // A token no statement can start with would otherwise stall the block
+            if (current_ == start) {
+                consume();
+            }
+            break;
+        }
+        case BlockFrame::Kind::ElseClause:
+            block_stack_.pop_back();
+            parse_else_clause(frame.node);
+            break;
+        case BlockFrame::Kind::DoWhileTail:
+            block_stack_.pop_back();
+            parse_do_while_condition(frame.node);
+            break;
+        case BlockFrame::Kind::MatchCases:
+            if (is_eof() || match(lex::TokenKind::End())) {
+                expect(lex::TokenKind::End(), "Expected 'end' after match cases");
+                block_stack_.pop_back();
+                break;
+            }
+            ast_.append_child(frame.node, parse_match_case());
+            break;
+        }
+    }
+}
+
 ziv::toolchain::ast::AST::Node Parser::parse_if_statement() {
-    auto if_node = ast_.add_node(ast::NodeKind::IfStatement(), consume());
+    auto if_node = add_node(ast::NodeKind::IfStatement(), consume());
 
     // Parse condition
     bool has_parens = consume_match(ziv::toolchain::lex::TokenKind::LParen());
 
     auto condition = parse_expression();
     if (condition.is_valid()) {
-        ast_.add_child(if_node, condition);
+        ast_.append_child(if_node, condition);
     }
 
     if (has_parens) {
         expect(ziv::toolchain::lex::TokenKind::RParen(), "Expected ')' at end of condition");
     }
 
-    // Parse block
+    // Parse block; the else clause is handled once the block is closed
     if (consume_match(lex::TokenKind::Colon())) {
-        auto block = parse_block();
+        block_stack_.push_back({BlockFrame::Kind::ElseClause, if_node});
+        auto block = open_block();
         if (block.is_valid()) {
-            ast_.add_child(if_node, block);
+            ast_.append_child(if_node, block);
         }
+    } else {
+        parse_else_clause(if_node);
     }
+    return if_node;
+}
 
+void Parser::parse_else_clause(ziv::toolchain::ast::AST::Node if_node) {
     // Handle else-if and else
     if (match(ziv::toolchain::lex::TokenKind::Else())) {
         consume();  // consume 'else'
         if (match(ziv::toolchain::lex::TokenKind::If())) {
             auto else_if = parse_if_statement();
             if (else_if.is_valid()) {
-                ast_.add_child(if_node, else_if);
+                ast_.append_child(if_node, else_if);
             }
         } else {
             auto else_block = parse_else_statement();
-            ast_.add_child(if_node, else_block);
+            ast_.append_child(if_node, else_block);
         }
     }
-    return if_node;
 }
 
 
 ziv::toolchain::ast::AST::Node Parser::parse_else_statement() {
-    auto else_node = ast_.add_node(ast::NodeKind::ElseStatement(), consume());
+    auto else_node = add_node(ast::NodeKind::ElseStatement(), consume());
 
     if (consume_match(lex::TokenKind::Colon())) {
-        auto block = parse_block();
+        auto block = open_block();
         if (block.is_valid()) {
-            ast_.add_child(else_node, block);
+            ast_.append_child(else_node, block);
         }
     }
     return else_node;
@@ -102,14 +186,14 @@ ziv::toolchain::ast::AST::Node Parser::parse_else_statement() {
 
 
 ziv::toolchain::ast::AST::Node Parser::parse_while_statement() {
-    auto while_node = ast_.add_node(ast::NodeKind::WhileLoop(), consume());
+    auto while_node = add_node(ast::NodeKind::WhileLoop(), consume());
 
     // Parse condition
     bool has_parens = consume_match(ziv::toolchain::lex::TokenKind::LParen());
 
     auto condition = parse_expression();
     if (condition.is_valid()) {
-        ast_.add_child(while_node, condition);
+        ast_.append_child(while_node, condition);
     }
 
     if (has_parens) {
@@ -118,9 +202,9 @@ ziv::toolchain::ast::AST::Node Parser::parse_while_statement() {
 
     // Parse block
     if (consume_match(lex::TokenKind::Colon())) {
-        auto block = parse_block();
+        auto block = open_block();
         if (block.is_valid()) {
-            ast_.add_child(while_node, block);
+            ast_.append_child(while_node, block);
         }
     }
     return while_node;
@@ -128,70 +212,70 @@ ziv::toolchain::ast::AST::Node Parser::parse_while_statement() {
 
 
 ziv::toolchain::ast::AST::Node Parser::parse_do_while_statement() {
-    auto do_while_node = ast_.add_node(ast::NodeKind::DoWhileLoop(), consume());
+    auto do_while_node = add_node(ast::NodeKind::DoWhileLoop(), consume());
 
-    auto block = parse_block();
+    // The trailing condition is parsed once the block is closed
+    block_stack_.push_back({BlockFrame::Kind::DoWhileTail, do_while_node});
+    auto block = open_block();
     if (block.is_valid()) {
-        ast_.add_child(do_while_node, block);
+        ast_.append_child(do_while_node, block);
     }
 
-    auto while_node = ast_.add_node(ast::NodeKind::WhileLoop(), consume());
-    ast_.add_child(do_while_node, while_node);
+    return do_while_node;
+}
+
+void Parser::parse_do_while_condition(ziv::toolchain::ast::AST::Node do_while_node) {
+    auto while_node = add_node(ast::NodeKind::WhileLoop(), consume());
+    ast_.append_child(do_while_node, while_node);
 
     // Parse condition
     bool has_parens = consume_match(ziv::toolchain::lex::TokenKind::LParen());
 
     auto condition = parse_expression();
     if (condition.is_valid()) {
-        ast_.add_child(while_node, condition);
+        ast_.append_child(while_node, condition);
     }
 
     if (has_parens) {
         expect(ziv::toolchain::lex::TokenKind::RParen(), "Expected ')' at end of condition");
     }
-
-    return do_while_node;
 }
 
 // Match Statement Support
 ziv::toolchain::ast::AST::Node Parser::parse_match_statement() {
-    auto match_stmt = ast_.add_node(ast::NodeKind::MatchStmt(), consume());
+    auto match_stmt = add_node(ast::NodeKind::MatchStmt(), consume());
 
     auto value = parse_expression();
-    ast_.add_child(match_stmt, value);
+    ast_.append_child(match_stmt, value);
 
     expect(lex::TokenKind::Colon(), "Expected ':' after match expression");
 
-    while (!is_eof() && !match(lex::TokenKind::End())) {
-        auto case_stmt = parse_match_case();
-        ast_.add_child(match_stmt, case_stmt);
-    }
-
-    expect(lex::TokenKind::End(), "Expected 'end' after match cases");
+    // Cases are parsed as a block frame, as their bodies may open blocks
+    block_stack_.push_back({BlockFrame::Kind::MatchCases, match_stmt});
     return match_stmt;
 }
 
 ziv::toolchain::ast::AST::Node Parser::parse_match_case() {
-    auto case_stmt = ast_.add_node(ast::NodeKind::CaseStmt(), peek());
+    auto case_stmt = add_node(ast::NodeKind::CaseStmt(), peek());
 
     auto pattern = parse_expression();
-    ast_.add_child(case_stmt, pattern);
+    ast_.append_child(case_stmt, pattern);
 
     expect(lex::TokenKind::Arrow(), "Expected '=>' after match pattern");
 
     auto body = parse_statement();
-    ast_.add_child(case_stmt, body);
+    ast_.append_child(case_stmt, body);
 
     return case_stmt;
 }
 
 ziv::toolchain::ast::AST::Node Parser::parse_for_statement() {
-    auto for_node = ast_.add_node(ast::NodeKind::ForLoop(), consume());
+    auto for_node = add_node(ast::NodeKind::ForLoop(), consume());
 
     // Parse initialization
     auto init = parse_statement();
     if (init.is_valid()) {
-        ast_.add_child(for_node, init);
+        ast_.append_child(for_node, init);
     }
 
     expect(lex::TokenKind::Semicolon(), "Expected ';' after for loop initialization");
@@ -199,7 +283,7 @@ ziv::toolchain::ast::AST::Node Parser::parse_for_statement() {
     // Parse condition
     auto condition = parse_expression();
     if (condition.is_valid()) {
-        ast_.add_child(for_node, condition);
+        ast_.append_child(for_node, condition);
     }
 
     expect(lex::TokenKind::Semicolon(), "Expected ';' after for loop condition");
@@ -207,13 +291,13 @@ ziv::toolchain::ast::AST::Node Parser::parse_for_statement() {
     // Parse increment
     auto increment = parse_expression();
     if (increment.is_valid()) {
-        ast_.add_child(for_node, increment);
+        ast_.append_child(for_node, increment);
     }
 
     // Parse block
-    auto block = parse_block();
+    auto block = open_block();
     if (block.is_valid()) {
-        ast_.add_child(for_node, block);
+        ast_.append_child(for_node, block);
     }
 
     return for_node;
@@ -221,12 +305,12 @@ ziv::toolchain::ast::AST::Node Parser::parse_for_statement() {
 
 ziv::toolchain::ast::AST::Node Parser::parse_return_statement() {
     expect(lex::TokenKind::Return(), "return");
-    auto return_node = ast_.add_node(ast::NodeKind::ReturnStmt(), previous());
+    auto return_node = add_node(ast::NodeKind::ReturnStmt(), previous());
 
     // Parse return value if there is one
     auto value = parse_expression();
     if (value.is_valid()) {
-        ast_.add_child(return_node, value);
+        ast_.append_child(return_node, value);
     }
 
     expect(lex::TokenKind::Semicolon(), "Expected ';' after return statement");
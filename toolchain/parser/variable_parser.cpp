@@ -8,29 +8,29 @@ namespace ziv::toolchain::parser {
 
 ziv::toolchain::ast::AST::Node Parser::parse_variable_declaration() {
     // Consume let/var
-    auto var_decl = ast_.add_node(ast::NodeKind::VarDecl(), consume());
+    auto var_decl = add_node(ast::NodeKind::VarDecl(), consume());
 
     // Handle let/mut/const
     expect(lex::TokenKind::Identifier(), "Expected variable declaration type");
 
-    auto var_name = ast_.add_node(ast::NodeKind::VariableName(), consume());
-    ast_.add_child(var_decl, var_name);
+    auto var_name = add_node(ast::NodeKind::VariableName(), consume());
+    ast_.append_child(var_decl, var_name);
 
     // Parse type annotation
     expect(lex::TokenKind::Colon(), "Expected ':' after variable name");
 
     auto type_spec = parse_type_specifier();
-    ast_.add_child(var_decl, type_spec);
+    ast_.append_child(var_decl, type_spec);
 
     // Parse initialization
     expect(lex::TokenKind::Equals(), "=");
 
-    auto init_expr = ast_.add_node(ast::NodeKind::VariableInit(), peek());
+    auto init_expr = add_node(ast::NodeKind::VariableInit(), peek());
     auto expr = parse_expression();
     if (expr.is_valid()) {
-        ast_.add_child(init_expr, expr);
+        ast_.append_child(init_expr, expr);
     }
-    ast_.add_child(var_decl, init_expr);
+    ast_.append_child(var_decl, init_expr);
 
     expect(lex::TokenKind::Semicolon(), "Expected ';' after variable declaration");
     return var_decl;
@@ -41,17 +41,17 @@ ziv::toolchain::ast::AST::Node Parser::parse_type_specifier() {
         emitter_.emit(diagnostics::DiagnosticKind::UnexpectedToken(),
                       peek().get_location(),
                       peek().get_name());
-        return ast_.add_node(ast::NodeKind::Error(), peek());
+        return add_node(ast::NodeKind::Error(), peek());
     }
 
-    auto base_type = ast_.add_node(ast::NodeKind::TypeSpec(), consume());
+    auto base_type = add_node(ast::NodeKind::TypeSpec(), consume());
     // Handle generic type arguments if present (e.g., Vec<T>)
     if (match(lex::TokenKind::Less())) {
         consume();  // Consume '<'
 
         while (!is_eof() && !match(lex::TokenKind::Greater())) {
             auto type_arg = parse_type_specifier();
-            ast_.add_child(base_type, type_arg);
+            ast_.append_child(base_type, type_arg);
 
             if (!match(lex::TokenKind::Greater())) {
                 if (!consume_match(lex::TokenKind::Comma())) {
@@ -82,23 +82,4 @@ ziv::toolchain::ast::AST::Node Parser::parse_delimiter() {
     return expr;
 }
 
-
-ziv::toolchain::ast::AST::Node Parser::parse_assignment() {
-    auto left = parse_logical_or();
-
-    if (match(ziv::toolchain::lex::TokenKind::Equals())) {
-        auto op = consume();
-        auto assignment_node = ast_.add_node(ast::NodeKind::AssignmentOp(), op);
-
-        ast_.add_child(assignment_node, left);
-
-        auto right = parse_assignment();  // Recurse to handle chained assignments
-        if (right.is_valid()) {
-            ast_.add_child(assignment_node, right);
-        }
-        return assignment_node;
-    }
-    return left;
-}
-
 }  // namespace ziv::toolchain::parser
@@ -12,24 +12,38 @@ bool SemanticChecker::check() {
     diagnostics::PhaseGuard guard(diagnostics::CompilationPhase::SemanticAnalysis);
     symbols_.enter_scope();
 
-    for (const auto& node : ast_.nodes()) {
-        if (!check_node(node)) {
-            return false;
-        }
+    if (!traverse(ast_, ast_.get_root())) {
+        return false;
     }
 
     symbols_.exit_scope();
     return true;
 }
 
-bool SemanticChecker::check_node(ast::AST::Node node) {
-    if (node.get_kind() == ast::NodeKind::VarDecl()) {
-        return check_variable_declaration(node);
-    } else if (node.get_kind() == ast::NodeKind::FunctionDecl()) {
-        return check_function_declaration(node);
-    }
+ast::VisitAction SemanticChecker::pre_visit_VarDecl(ast::AST::Node node) {
+    return check_variable_declaration(node) ? ast::VisitAction::SkipChildren
+                                            : ast::VisitAction::Stop;
+}
 
-    return true;
+// Functions open a scope for their parameters, left once the body is checked
+ast::VisitAction SemanticChecker::pre_visit_FunctionDecl(ast::AST::Node node) {
+    return check_function_declaration(node) ? ast::VisitAction::Continue
+                                            : ast::VisitAction::Stop;
+}
+
+void SemanticChecker::post_visit_FunctionDecl(ast::AST::Node /*node*/) {
+    symbols_.exit_scope();
+}
+
+// Blocks scope the variables declared in them, so sibling blocks may reuse
+// a name; a name visible from an enclosing scope is still a redeclaration
+ast::VisitAction SemanticChecker::pre_visit_CodeBlock(ast::AST::Node /*node*/) {
+    symbols_.enter_scope();
+    return ast::VisitAction::Continue;
+}
+
+void SemanticChecker::post_visit_CodeBlock(ast::AST::Node /*node*/) {
+    symbols_.exit_scope();
 }
 
 bool SemanticChecker::check_variable_declaration(ast::AST::Node node) {
@@ -38,16 +52,16 @@ bool SemanticChecker::check_variable_declaration(ast::AST::Node node) {
 
     if (name_node == ast_.children(node).end() || type_node == ast_.children(node).end()) {
         emitter_.emit(diagnostics::DiagnosticKind::VariableMissingType(),
-                      node.get_location(),
+                      ast_.get_location(node),
                       "variable declaration must have a name and a type");
         return false;
     }
-    llvm::StringRef name = (*name_node).get_spelling();
+    llvm::StringRef name = ast_.get_spelling(*name_node);
     Type* type = Type::get_Int_type();  // Using correct casing
 
     if (symbols_.lookup(name)) {
         emitter_.emit(diagnostics::DiagnosticKind::VariableRedeclaration(),
-                      node.get_location(),
+                      ast_.get_location(node),
                       "variable '{}' is already declared",
                       name);
         return false;
@@ -57,7 +71,7 @@ bool SemanticChecker::check_variable_declaration(ast::AST::Node node) {
 }
 
 Type* SemanticChecker::check_expression(ast::AST::Node node) {
-    if (node.get_kind() == ast::NodeKind::IntegerType()) {
+    if (ast_.get_kind(node) == ast::NodeKind::IntegerType()) {
         return Type::get_Int_type();  // Using correct casing
     }
 
@@ -70,17 +84,17 @@ bool SemanticChecker::check_function_declaration(ast::AST::Node node) {
     auto name_node = ast_.children(node).begin();
     if (name_node == ast_.children(node).end()) {
         emitter_.emit(diagnostics::DiagnosticKind::FunctionMissingName(),
-                      node.get_location(),
+                      ast_.get_location(node),
                       "function declaration must have a name");
         return false;
     }
 
-    llvm::StringRef name = (*name_node).get_spelling();
+    llvm::StringRef name = ast_.get_spelling(*name_node);
 
     // Check if function already declared
     if (symbols_.lookup(name)) {
         emitter_.emit(diagnostics::DiagnosticKind::FunctionMissingName(),
-                      node.get_location(),
+                      ast_.get_location(node),
                       "function '{}' is already declared",
                       name);
         return false;
@@ -92,14 +106,14 @@ bool SemanticChecker::check_function_declaration(ast::AST::Node node) {
     // Find parameter list and return type
     auto params_node = std::next(name_node);
     if (params_node != ast_.children(node).end()
-        && (*params_node).get_kind() == ast::NodeKind::ParameterList()) {
+        && ast_.get_kind(*params_node) == ast::NodeKind::ParameterList()) {
         // Check parameters...
         for (const auto& param : ast_.children(*params_node)) {
             auto param_name = ast_.children(param).begin();
             if (param_name != ast_.children(param).end()) {
                 // For now, assume all parameters are int type
                 symbols_.define(Symbol(Symbol::Kind::KVariable,
-                                       (*param_name).get_spelling(),
+                                       ast_.get_spelling(*param_name),
                                        Type::get_Int_type()));
             }
         }
@@ -110,24 +124,7 @@ bool SemanticChecker::check_function_declaration(ast::AST::Node node) {
     Type* return_type = Type::get_Int_type();
     symbols_.define(Symbol(Symbol::Kind::KFunction, name, return_type));
 
-    // Check function body if it exists
-    auto body_node = std::find_if(ast_.children(node).begin(),
-                                  ast_.children(node).end(),
-                                  [](const ast::AST::Node& n) {
-                                      return n.get_kind() == ast::NodeKind::CodeBlock();
-                                  });
-
-    if (body_node != ast_.children(node).end()) {
-        for (const auto& stmt : ast_.children(*body_node)) {
-            if (!check_node(stmt)) {
-                symbols_.exit_scope();
-                return false;
-            }
-        }
-    }
-
-    // Exit function scope
-    symbols_.exit_scope();
+    // The body is visited after this, still in the function scope
     return true;
 }
 
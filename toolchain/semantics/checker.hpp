@@ -7,12 +7,13 @@
 
 #include "symbol_table.hpp"
 #include "toolchain/ast/tree.hpp"
+#include "toolchain/ast/visitor.hpp"
 #include "toolchain/diagnostics/diagnostic_consumer.hpp"
 #include "toolchain/diagnostics/diagnostic_emitter.hpp"
 
 namespace ziv::toolchain::semantics {
 
-class SemanticChecker {
+class SemanticChecker : public ast::ASTVisitor<SemanticChecker> {
 public:
     SemanticChecker(ast::AST& ast,
                     std::shared_ptr<diagnostics::DiagnosticConsumer> consumer,
@@ -22,8 +23,14 @@ public:
 
     bool check();
 
+    // Visitor hooks
+    ast::VisitAction pre_visit_VarDecl(ast::AST::Node node);
+    ast::VisitAction pre_visit_FunctionDecl(ast::AST::Node node);
+    void post_visit_FunctionDecl(ast::AST::Node node);
+    ast::VisitAction pre_visit_CodeBlock(ast::AST::Node node);
+    void post_visit_CodeBlock(ast::AST::Node node);
+
 private:
-    bool check_node(ast::AST::Node node);
     bool check_variable_declaration(ast::AST::Node node);
     bool check_function_declaration(ast::AST::Node node);
     Type* check_expression(ast::AST::Node node);
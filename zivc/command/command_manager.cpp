@@ -6,6 +6,7 @@
 
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
+#include "toolchain/ast/printer.hpp"
 #include "zivc/toolchain/driver.hpp"
 
 namespace ziv::cli::command {
@@ -31,6 +32,21 @@ static llvm::cl::opt<bool> parser_command("dump-tree",
                                           llvm::cl::desc("Dump the AST tree"),
                                           llvm::cl::sub(toolchain_command));
 
+static llvm::cl::opt<bool> outline_command(
+    "dump-outline",
+    llvm::cl::desc("Dump the AST outline, leaving function bodies unparsed"),
+    llvm::cl::sub(toolchain_command));
+
+static llvm::cl::opt<ziv::toolchain::ast::DumpFormat> dump_format(
+    "dump-format",
+    llvm::cl::desc("Format of --dump-tree and --dump-outline"),
+    llvm::cl::values(
+        clEnumValN(ziv::toolchain::ast::DumpFormat::Tree, "tree", "Indented tree (default)"),
+        clEnumValN(ziv::toolchain::ast::DumpFormat::Json, "json", "Nested JSON objects"),
+        clEnumValN(ziv::toolchain::ast::DumpFormat::Binary, "binary", "Binary .zast tree")),
+    llvm::cl::init(ziv::toolchain::ast::DumpFormat::Tree),
+    llvm::cl::sub(toolchain_command));
+
 static llvm::cl::opt<std::string> input_file(llvm::cl::Positional,
                                              llvm::cl::desc("<input file>"),
                                              llvm::cl::sub(toolchain_command),
@@ -50,6 +66,9 @@ void CommandManager::execute(int argc, char** argv) {
         if (parser_command) {
             handle_parser(input_file);
         }
+        if (outline_command) {
+            handle_outline(input_file);
+        }
     } else {
         llvm::errs() << "Error: No command specified\n";
     }
@@ -66,8 +85,13 @@ void CommandManager::handle_lexer(const std::string& filename) {
 }
 
 void CommandManager::handle_parser(const std::string& filename) {
-    ziv::cli::toolchain::ToolchainDriver driver;
+    ziv::cli::toolchain::ToolchainDriver driver(dump_format);
     driver.run("parser", filename);
 }
 
+void CommandManager::handle_outline(const std::string& filename) {
+    ziv::cli::toolchain::ToolchainDriver driver(dump_format);
+    driver.run("outline", filename);
+}
+
 }  // namespace ziv::cli::command
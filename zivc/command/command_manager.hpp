@@ -17,6 +17,7 @@ private:
     void handle_source(const std::string& filename);
     void handle_lexer(const std::string& filename);
     void handle_parser(const std::string& filename);
+    void handle_outline(const std::string& filename);
 };
 
 }  // namespace ziv::cli::command
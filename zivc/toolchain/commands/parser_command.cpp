@@ -16,7 +16,6 @@ namespace ziv::cli::toolchain {
 void ParserCommand::execute(const std::string& args) {
     llvm::vfs::FileSystem& fs = *llvm::vfs::getRealFileSystem();
     auto source = ziv::toolchain::source::SourceBuffer::from_file(fs, args);
-    ziv::toolchain::lex::TokenBuffer buffer = ziv::toolchain::lex::TokenBuffer(*source);
     auto consumer = std::make_shared<ziv::toolchain::diagnostics::ConsoleDiagnosticConsumer>(
         *source);
     ziv::toolchain::lex::Lexer lexer(*source, consumer);
@@ -24,16 +23,14 @@ void ParserCommand::execute(const std::string& args) {
     lexer.lex();  // Lex the source file
     consumer->print_summary();
 
-    const auto& tokens = lexer.get_tokens();
-
     ziv::toolchain::ast::AST ast;
-    ziv::toolchain::parser::Parser parser(tokens, ast, consumer, *source);
+    ziv::toolchain::parser::Parser parser(lexer.get_buffer(), ast, consumer, *source, options_);
 
     parser.parse();  // Parse the token buffer
     consumer->print_summary();
 
     ziv::toolchain::ast::Printer printer(ast);
-    printer.print(llvm::outs());
+    printer.print(llvm::outs(), dump_format_);
 
     ziv::toolchain::semantics::SemanticChecker checker(ast, consumer, *source);
     bool success = checker.check();
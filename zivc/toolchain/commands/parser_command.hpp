@@ -7,6 +7,7 @@
 
 #include "llvm/Support/VirtualFileSystem.h"
 #include "llvm/Support/raw_ostream.h"
+#include "toolchain/ast/printer.hpp"
 #include "toolchain/ast/tree.hpp"
 #include "toolchain/parser/parser.hpp"
 #include "zivc/toolchain/command.hpp"
@@ -14,7 +15,16 @@
 namespace ziv::cli::toolchain {
 class ParserCommand : public Command {
 public:
+    explicit ParserCommand(
+        ziv::toolchain::parser::ParserOptions options = {},
+        ziv::toolchain::ast::DumpFormat dump_format = ziv::toolchain::ast::DumpFormat::Tree)
+        : options_(options), dump_format_(dump_format) {}
+
     void execute(const std::string& args) override;
+
+private:
+    ziv::toolchain::parser::ParserOptions options_;
+    ziv::toolchain::ast::DumpFormat dump_format_;
 };
 }  // namespace ziv::cli::toolchain
 
@@ -10,11 +10,14 @@
 
 namespace ziv::cli::toolchain {
 
-ToolchainDriver::ToolchainDriver() {
+ToolchainDriver::ToolchainDriver(ziv::toolchain::ast::DumpFormat dump_format) {
     // registry commands
     commands_["source"] = std::make_unique<SourceCommand>();
     commands_["lexer"] = std::make_unique<LexerCommand>();
-    commands_["parser"] = std::make_unique<ParserCommand>();
+    commands_["parser"] = std::make_unique<ParserCommand>(ziv::toolchain::parser::ParserOptions{},
+                                                          dump_format);
+    commands_["outline"] = std::make_unique<ParserCommand>(
+        ziv::toolchain::parser::ParserOptions{.outline = true}, dump_format);
 }
 
 void ToolchainDriver::run(const std::string& command, const std::string& arg) {
@@ -10,12 +10,14 @@
 #include <unordered_map>
 
 #include "command.hpp"
+#include "toolchain/ast/printer.hpp"
 
 namespace ziv::cli::toolchain {
 
 class ToolchainDriver {
 public:
-    ToolchainDriver();
+    explicit ToolchainDriver(
+        ziv::toolchain::ast::DumpFormat dump_format = ziv::toolchain::ast::DumpFormat::Tree);
     void run(const std::string& command, const std::string& args);
 
 private: